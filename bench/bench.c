@@ -0,0 +1,165 @@
+#include "../callater.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_N 1000000
+#define BENCH_CANCEL_N 20000
+#define BENCH_SCAN_UPDATES 200
+#define BENCH_TIME_READS 1000000
+
+static double Now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void Nothing(void *arg, CallaterRef ref)
+{
+    (void)arg;
+    (void)ref;
+}
+
+static float delays[BENCH_N];
+static void *args[BENCH_N];
+static void(*funcs[BENCH_N])(void*, CallaterRef);
+static CallaterRef refs[BENCH_N];
+
+static void BenchInvoke()
+{
+    CallaterInit();
+    double start = Now();
+    for(int i = 0 ; i < BENCH_N ; i++)
+    {
+        refs[i] = CallaterInvoke(Nothing, args[i], delays[i]);
+    }
+    double end = Now();
+    printf("CallaterInvoke loop     : %8.3f ms (%6.2f ns/invoke)\n", (end - start) * 1e3, (end - start) * 1e9 / BENCH_N);
+    CallaterDeinit();
+}
+
+static void BenchInvokeBatch()
+{
+    CallaterInit();
+    double start = Now();
+    CallaterInvokeBatch(funcs, args, delays, NULL, NULL, BENCH_N, refs);
+    double end = Now();
+    printf("CallaterInvokeBatch     : %8.3f ms (%6.2f ns/invoke)\n", (end - start) * 1e3, (end - start) * 1e9 / BENCH_N);
+    CallaterDeinit();
+}
+
+static void BenchInvokeBatchArgs()
+{
+    CallaterInit();
+    double start = Now();
+    CallaterInvokeBatchArgs(Nothing, args, 1.0f, -1.0f, (CallaterGroupId)-1, BENCH_N, refs);
+    double end = Now();
+    printf("CallaterInvokeBatchArgs : %8.3f ms (%6.2f ns/invoke)\n", (end - start) * 1e3, (end - start) * 1e9 / BENCH_N);
+    CallaterDeinit();
+}
+
+// cancelling in due order makes every CallaterCancel hit the min invoke time
+static void BenchCancel()
+{
+    CallaterInit();
+    for(int i = 0 ; i < BENCH_CANCEL_N ; i++)
+    {
+        refs[i] = CallaterInvoke(Nothing, NULL, (float)i / BENCH_CANCEL_N);
+    }
+    double start = Now();
+    for(int i = 0 ; i < BENCH_CANCEL_N ; i++)
+    {
+        CallaterCancel(refs[i]);
+    }
+    double end = Now();
+    printf("CallaterCancel loop     : %8.3f ms (%6.2f ns/cancel)\n", (end - start) * 1e3, (end - start) * 1e9 / BENCH_CANCEL_N);
+    CallaterDeinit();
+}
+
+static void BenchCancelMany()
+{
+    CallaterInit();
+    for(int i = 0 ; i < BENCH_CANCEL_N ; i++)
+    {
+        refs[i] = CallaterInvoke(Nothing, NULL, (float)i / BENCH_CANCEL_N);
+    }
+    double start = Now();
+    CallaterCancelMany(refs, BENCH_CANCEL_N);
+    double end = Now();
+    printf("CallaterCancelMany      : %8.3f ms (%6.2f ns/cancel)\n", (end - start) * 1e3, (end - start) * 1e9 / BENCH_CANCEL_N);
+    CallaterDeinit();
+}
+
+// every invocation is due on the first update, so this is the cost of dispatching them
+static void BenchUpdateAllDue()
+{
+    CallaterInit();
+    CallaterInvokeBatchArgs(Nothing, args, 0.0f, -1.0f, (CallaterGroupId)-1, BENCH_N, refs);
+    double start = Now();
+    CallaterUpdate();
+    double end = Now();
+    printf("CallaterUpdate all due  : %8.3f ms (%6.2f ns/invoke)\n", (end - start) * 1e3, (end - start) * 1e9 / BENCH_N);
+    CallaterDeinit();
+}
+
+// one invocation is due per update and the rest are within the horizon, so each update scans every lane
+static void BenchUpdateScan()
+{
+    CallaterInit();
+    CallaterSetEngine(CALLATER_ENGINE_LINEAR);
+    CallaterInvokeBatchArgs(Nothing, args, 1.0f, -1.0f, (CallaterGroupId)-1, BENCH_N, refs);
+    double start = Now();
+    for(int i = 0 ; i < BENCH_SCAN_UPDATES ; i++)
+    {
+        CallaterInvoke(Nothing, NULL, 0.0f);
+        CallaterUpdate();
+    }
+    double end = Now();
+    printf("CallaterUpdate one due  : %8.3f ms (%6.3f ms/update)\n", (end - start) * 1e3, (end - start) * 1e3 / BENCH_SCAN_UPDATES);
+    CallaterDeinit();
+}
+
+// every `CallaterInvokesAfter` reads the clock once
+static void BenchTimeRead()
+{
+    CallaterInit();
+    CallaterRef ref = CallaterInvoke(Nothing, NULL, 1.0f);
+    volatile float sink = 0;
+    double start = Now();
+    for(int i = 0 ; i < BENCH_TIME_READS ; i++)
+    {
+        sink += CallaterInvokesAfter(ref);
+    }
+    double end = Now();
+    (void)sink;
+    printf("CallaterInvokesAfter    : %8.3f ms (%6.2f ns/read)\n", (end - start) * 1e3, (end - start) * 1e9 / BENCH_TIME_READS);
+    CallaterDeinit();
+}
+
+int main()
+{
+    srand(1234);
+    for(int i = 0 ; i < BENCH_N ; i++)
+    {
+        delays[i] = 10.0f * rand() / RAND_MAX;
+        args[i] = &delays[i];
+        funcs[i] = Nothing;
+    }
+    
+    printf("%d invocations\n", BENCH_N);
+    BenchInvoke();
+    BenchInvokeBatch();
+    BenchInvokeBatchArgs();
+    
+    printf("\n%d cancels in due order\n", BENCH_CANCEL_N);
+    BenchCancel();
+    BenchCancelMany();
+    
+    printf("\n%d invocations ticked\n", BENCH_N);
+    BenchUpdateAllDue();
+    BenchUpdateScan();
+    
+    printf("\n%d time reads\n", BENCH_TIME_READS);
+    BenchTimeRead();
+}
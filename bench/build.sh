@@ -0,0 +1,10 @@
+#!/bin/bash
+
+gcc -mavx ../callater.c bench.c -I "../" -lm -o bench -O3 -std=gnu11 -Wall -Wextra || exit $?
+
+# same benchmark without pausing, groups and repeats, for the smaller per invocation footprint
+gcc -mavx -DCALLATER_NO_PAUSE -DCALLATER_NO_GROUPS -DCALLATER_NO_REPEAT ../callater.c bench.c -I "../" -lm -o bench_stripped -O3 -std=gnu11 -Wall -Wextra || exit $?
+
+# same benchmark reading the time from the TSC
+gcc -mavx -DCALLATER_TSC ../callater.c bench.c -I "../" -lm -o bench_tsc -O3 -std=gnu11 -Wall -Wextra || exit $?
+
@@ -1,13 +1,26 @@
+// for mremap
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include "callater.h"
 #include <math.h>
 #include <stdlib.h>
 #include <time.h>
 #include <stdint.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdbool.h>
 #include <assert.h>
 #include <immintrin.h>
 
+#ifdef __linux__
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#endif
+
 #ifdef _WIN32
 
 #define WIN32_LEAN_AND_MEAN
@@ -19,6 +32,20 @@
 
 #endif
 
+// the TSC clock source needs x86 and is opt-in, since calibrating it busy waits in `CallaterInit`
+#if defined(CALLATER_TSC) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64))
+
+#define CALLATER_HAS_TSC
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+#endif
+
 #ifdef _MSC_VER
 
 #define CALLATER_M256_AT(vec, idx) vec.m256_f32[idx]
@@ -32,25 +59,238 @@
 #define CALLATER_FLT_AS_INT(f) \
 ((union{float asFloat; int32_t asInt;}){.asFloat = f}.asInt)
 
-typedef struct CallaterPausedInvoke
-{
-    CallaterRef ref;
-    float delay;
-} CallaterPausedInvoke;
+// invocations due further than this many seconds away are kept out of the SIMD scan
+#ifndef CALLATER_DEFAULT_HORIZON
+#define CALLATER_DEFAULT_HORIZON 2.0f
+#endif
+
+// the adaptive engine moves to the heap once this many invocations are live and few of them are due per update
+#ifndef CALLATER_ADAPTIVE_HEAP_COUNT
+#define CALLATER_ADAPTIVE_HEAP_COUNT 16384
+#endif
+
+// number of updates between two decisions of the adaptive engine
+#ifndef CALLATER_ADAPTIVE_PERIOD
+#define CALLATER_ADAPTIVE_PERIOD 64
+#endif
+
+// bytes `CallaterInvokeCopy` can store inline per invocation, keep it a multiple of `alignof(max_align_t)`
+#ifndef CALLATER_PAYLOAD_SIZE
+#define CALLATER_PAYLOAD_SIZE 32
+#endif
+
+// `CallaterHugePageAllocator` maps allocations at least this big with mmap and asks for huge pages
+#ifndef CALLATER_HUGE_PAGE_THRESHOLD
+#define CALLATER_HUGE_PAGE_THRESHOLD (2 * 1024 * 1024)
+#endif
+
+#if defined(__linux__) || defined(_WIN32)
+#define CALLATER_HAS_VIRTUAL_MEMORY
+#endif
+
+// `CallaterWait` sleeps until this many seconds before a precise invocation is due, then spins
+#ifndef CALLATER_SPIN_MARGIN
+#define CALLATER_SPIN_MARGIN 0.002f
+#endif
+
+// seconds of the OS clock the TSC is calibrated against
+#ifndef CALLATER_TSC_CALIBRATION
+#define CALLATER_TSC_CALIBRATION 0.002
+#endif
+
+// `slackExp` of invocations without slack, the lowest value its 7 bits hold
+#define CALLATER_NO_SLACK -64
+
+// marks the end of a cohort and refs that don't point to a slot
+#define CALLATER_NO_SLOT ((CallaterIndex)-1)
 
-typedef struct CallaterPauseArray
+#define CALLATER_NO_GROUP ((CallaterGroupId)-1)
+
+#ifdef CALLATER_NO_GROUPS
+#define CALLATER_SET_GROUP(data, id) ((void)(id))
+#else
+#define CALLATER_SET_GROUP(data, id) ((data).groupId = (id))
+#endif
+
+#ifdef CALLATER_NO_REPEAT
+#define CALLATER_SET_REPEAT(data, rate) ((void)(rate))
+#define CALLATER_SET_POLICY(data, policy) ((void)(policy))
+#else
+#define CALLATER_SET_REPEAT(data, rate) ((data).repeatRate = (rate))
+#define CALLATER_SET_POLICY(data, policy) ((data).repeatPolicy = (policy))
+#endif
+
+#ifdef CALLATER_COMPACT_ARGS
+typedef uint32_t CallaterArg;
+#define CALLATER_ARG_PACK(arg)   ((CallaterArg)(uintptr_t)(arg))
+#define CALLATER_ARG_UNPACK(arg) ((void*)(uintptr_t)(arg))
+#else
+typedef void *CallaterArg;
+#define CALLATER_ARG_PACK(arg)   (arg)
+#define CALLATER_ARG_UNPACK(arg) (arg)
+#endif
+
+// number of slots whose payloads share one allocation
+#define CALLATER_PAYLOAD_BLOCK 256
+
+// max number of distinct repeat rates that get their own FIFO at the same time. At most 64
+#ifndef CALLATER_MAX_COHORTS
+#define CALLATER_MAX_COHORTS 32
+#endif
+
+// number of priority lanes, see `CallaterSetPriority`. At most 8
+#ifndef CALLATER_PRIORITY_LANES
+#define CALLATER_PRIORITY_LANES 4
+#endif
+
+// buckets of the frame wheel, a power of two. Invocations more frames away than that wait in their bucket for a few rounds
+#ifndef CALLATER_FRAME_BUCKETS
+#define CALLATER_FRAME_BUCKETS 256
+#endif
+
+// max number of clocks alive at once, the global clock included. At most 256
+#ifndef CALLATER_MAX_CLOCKS
+#define CALLATER_MAX_CLOCKS 16
+#endif
+
+// where the invocation of a slot is currently stored
+typedef enum CallaterStore
 {
-    CallaterPausedInvoke *pausedInvokes;
-    uint64_t count, cap;
-} CallaterPauseArray;
+    CALLATER_STORE_NONE,   // empty slot
+    CALLATER_STORE_HOT,    // `storeIndex` is its lane in `table.hot`
+    CALLATER_STORE_FAR,    // `storeIndex` is its position in the `table.far` heap
+    CALLATER_STORE_PAUSED, // its time lane holds the remaining delay, see `CallaterPausedTime`
+    CALLATER_STORE_DUE,    // collected by `CallaterTick` and waiting to be called
+    CALLATER_STORE_COHORT, // `storeIndex` is the previous slot in its cohort, `next` the next one
+    CALLATER_STORE_CLOCK,  // `storeIndex` is its position in the heap of its clock
+    CALLATER_STORE_NEXT_UPDATE, // `storeIndex` is its position in `table.deferNext`, see `CallaterDeferQueue`
+    CALLATER_STORE_END_OF_UPDATE, // `storeIndex` is its position in `table.deferEndOfUpdate`
+    CALLATER_STORE_FRAME,  // `storeIndex` is the frame it's due on, it sits in the bucket of that frame in `table.frameWheel`
+} CallaterStore;
 
 typedef struct CallaterInvokeData
 {
-    uint64_t groupId;
-    uint64_t pausedIndex;
+#ifndef CALLATER_NO_GROUPS
+    CallaterGroupId groupId;
+#endif
+    CallaterIndex storeIndex;
+#ifndef CALLATER_NO_REPEAT
+    CallaterIndex next;
     float repeatRate; // if neg, then no repeat
+#endif
+    // the rest fits in 32 bits, so a compact slot stays at 20 bytes
+    uint32_t store    : 4;
+    uint32_t clock    : 8; // index in `table.clocks`, its invoke time is in that clock's time
+#ifndef CALLATER_NO_REPEAT
+    uint32_t cohort   : 6;
+    uint32_t repeatPolicy : 2;
+#endif
+    uint32_t precise  : 1; // see `CallaterSetPrecise`
+    uint32_t frames   : 1; // its repeat rate and paused delay count frames, see `CallaterInvokeAfterFrames`
+    uint32_t priority : 3; // its lane, 0 is called first
+    int32_t slackExp  : 7; // its invoke times are rounded up to multiples of 2^slackExp seconds, see `CallaterSetSlack`
 } CallaterInvokeData;
 
+_Static_assert(CALLATER_MAX_CLOCKS <= 256 && CALLATER_MAX_COHORTS <= 64 && CALLATER_PRIORITY_LANES <= 8,
+               "too many clocks, cohorts or lanes for the bits of `CallaterInvokeData`");
+
+// invocations due within `table.horizon`, these are the only ones the SIMD scan looks at
+// lanes are kept dense, `slots` maps each lane back to its slot in the table
+typedef struct CallaterHotArray
+{
+    float *invokeTimes;
+    CallaterIndex *slots;
+    uint64_t count;
+    uint64_t cap;
+} CallaterHotArray;
+
+typedef struct CallaterFarInvoke
+{
+    CallaterIndex slot;
+    float invokeTime;
+} CallaterFarInvoke;
+
+// min-heap of the invocations due after `table.horizon`
+// they get promoted to the hot array in batches as time advances
+// with the heap engine every non-cohort invocation lives here
+typedef struct CallaterFarStore
+{
+    CallaterFarInvoke *invokes;
+    uint64_t count;
+    uint64_t cap;
+} CallaterFarStore;
+
+// repeating invocations that share a repeat rate get rescheduled to `curTime + repeatRate`
+// in the order they're called, so they stay sorted in a plain FIFO and never need a compare scan
+typedef struct CallaterCohort
+{
+    float repeatRate;
+    CallaterIndex first, last;
+    uint64_t count;
+} CallaterCohort;
+
+// invocations on a child clock sit in its own heap, with their invoke times in its local time
+// every update the clock moves by its parent's step times `scale`, so pausing or scaling it costs nothing per invocation
+// the global clock (index 0) is real time, its invocations are kept by the backend like before
+typedef struct CallaterClockState
+{
+    CallaterFarStore heap;
+    float time; // local time as of the last update
+    float dt;   // how far `time` moved on the last update
+    float scale;
+    uint32_t parent; // always a lower index, so the clocks can be advanced in order
+    bool paused;
+    bool alive;
+} CallaterClockState;
+
+// where the invocations that aren't in a cohort are kept and how the due ones are found
+typedef struct CallaterBackend
+{
+    CallaterEngine engine;
+    // stores the invocation, `table.invokeTimes[idx]` is already set. Returns false if there's no memory for it
+    bool(*schedule)(uint64_t idx, float invokeTime);
+    // called on every update before checking `table.minInvokeTime`
+    void(*advance)(float curTime);
+    // marks the due invocations and appends them to `table.dueSlots`, returns the new due count
+    uint64_t(*collectDue)(float curTime, uint64_t dueCount);
+    float(*minInvokeTime)();
+    // takes over the invocations held by the other backend
+    void(*migrateIn)();
+} CallaterBackend;
+
+typedef struct CallaterAdaptiveStats
+{
+    float dueRatio; // moving average of due invocations per update over live invocations
+    uint64_t updates;
+} CallaterAdaptiveStats;
+
+// payloads copied by `CallaterInvokeCopy`, indexed by slot so they're recycled along with it
+// blocks are never moved, so the pointers passed to the callbacks stay valid when the table grows
+typedef struct CallaterPayloadSlab
+{
+    unsigned char **blocks; // block `b` holds the payloads of slots `b * CALLATER_PAYLOAD_BLOCK` and up
+    uint64_t blockCount;
+} CallaterPayloadSlab;
+
+// FIFO of the invocations added by `CallaterDefer` or `CallaterDeferEndOfUpdate`, drained without comparing any time
+// positions only ever grow and entry `pos` lives at `slots[pos & (cap - 1)]`. Cancelled entries stay in the ring:
+// an entry is only called if its slot is still in `store` with `storeIndex == pos`
+typedef struct CallaterDeferQueue
+{
+    CallaterIndex *slots;
+    uint8_t store;
+    uint64_t cap; // power of two
+    uint64_t head;
+    uint64_t tail;
+} CallaterDeferQueue;
+
+// the part of the buffer passed to `CallaterInitFixed` that wasn't handed out yet
+typedef struct CallaterArena
+{
+    unsigned char *cursor;
+    unsigned char *end;
+} CallaterArena;
+
 typedef struct CallaterTable
 {
     uint64_t cap;
@@ -58,20 +298,63 @@ typedef struct CallaterTable
     uint64_t noopCount;
     uint64_t nextEmptySpot;
     void(**funcs)(void*, CallaterRef);
-    void **args;
+    CallaterArg *args;
     uint64_t startSec;
     uint64_t clockFreq;
+#ifdef CALLATER_HAS_TSC
+    uint64_t tscStart;
+    double tscPeriod; // seconds per TSC tick, 0 if the TSC isn't invariant and the OS clock is used
+    double tscBase; // the time of the OS clock at `tscStart`
+#endif
+    float(*timeSource)(void *user); // replaces the OS clock when not NULL
+    void *timeSourceUser;
+    bool frameTime; // inserts and resumes use `lastUpdated` instead of reading the clock
+    bool fixedStep; // inside the substeps of `CallaterUpdateFixed`, inserts count from the substep and due sets are sorted
+    uint64_t preciseCount; // while not 0 updates read the fine clock
+    uint64_t laneBudgets[CALLATER_PRIORITY_LANES]; // max calls per update of each lane
+    bool laneBudgeted; // any of `laneBudgets` is set
+    int8_t defaultSlackExp; // `slackExp` of new invocations, see `CallaterSetDefaultSlack`
+#ifndef CALLATER_NO_REPEAT
+    CallaterIndex missedSlot; // the invocation being called and the periods folded into that call, see `CallaterGetMissed`
+    uint64_t missed;
+    bool staggerRepeats; // every repeating invocation added gets a phase, see `CallaterSetStaggerRepeats`
+#endif
+    CallaterAllocator allocator;
+    CallaterArena arena;
+    bool fixed; // initialized with `CallaterInitFixed`, the arrays never grow
+    uint64_t maxCap; // capacity reserved by `CallaterInitVirtual`, 0 otherwise
     float *invokeTimes;
     CallaterInvokeData *invokeData;
-    CallaterPauseArray pausedInvokes;
+    CallaterHotArray hot;
+    CallaterFarStore far;
+#ifndef CALLATER_NO_REPEAT
+    CallaterCohort cohorts[CALLATER_MAX_COHORTS];
+#endif
+    CallaterDeferQueue deferNext;        // called at the start of the next update
+    CallaterDeferQueue deferEndOfUpdate; // called at the end of the current update
+    CallaterDeferQueue *frameWheel; // `CALLATER_FRAME_BUCKETS` rings, allocated on first use
+    uint64_t frameCount; // invocations in `table.frameWheel`, not counting stale entries
+    uint64_t frame; // number of updates so far
+    CallaterClockState clocks[CALLATER_MAX_CLOCKS];
+    uint64_t clockCount; // one past the highest clock alive
+    CallaterPayloadSlab payloads;
+    const CallaterBackend *backend;
+    CallaterEngine engine;
+    CallaterAdaptiveStats adaptive;
+    CallaterIndex *dueSlots; // as long as the biggest due set so far
+    uint64_t dueCap;
     float minInvokeTime;
     float lastUpdated;
-    unsigned char delaysPtrOffset;
+    float horizon;
 } CallaterTable;
 
 static CallaterTable table = { 0 };
 
-struct timespec CallaterGetTimespec()
+static const CallaterBackend callaterLinearBackend;
+static const CallaterBackend callaterHeapBackend;
+
+// `fine` only matters on Linux, where the coarse clock is much cheaper to read but ticks every 1 to 4 ms
+struct timespec CallaterGetTimespec(bool fine)
 {
 #if defined(__MINGW32__)
     struct timespec ts;
@@ -83,332 +366,2484 @@ struct timespec CallaterGetTimespec()
     return ts;
 #else
     struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    clock_gettime(fine ? CLOCK_MONOTONIC : CLOCK_MONOTONIC_COARSE, &ts);
     return ts;
 #endif
 }
 
-float CallaterCurrentTime()
+#ifdef CALLATER_HAS_TSC
+
+// on the timebase of the OS clock, so times read from both can be compared
+static float CallaterTscTime()
+{
+    return table.tscBase + (__rdtsc() - table.tscStart) * table.tscPeriod;
+}
+
+#endif
+
+static float CallaterReadTime(bool fine)
 {
+    if(table.timeSource != NULL)
+        return table.timeSource(table.timeSourceUser);
 #ifdef CALLATER_TEST
+    (void)fine;
     return mock_current_time;
 #else
+#ifdef CALLATER_HAS_TSC
+    // only fine reads need its resolution, the coarse clock is cheaper for the rest
+    if(fine && table.tscPeriod != 0)
+        return CallaterTscTime();
+#endif
 #ifdef _WIN32
     uint64_t time;
     QueryPerformanceCounter((void*)&time);
     return (time - table.startSec * table.clockFreq) / (float) table.clockFreq;
 #else
-    struct timespec ts = CallaterGetTimespec();
+    struct timespec ts = CallaterGetTimespec(fine);
     return ts.tv_sec - table.startSec + ts.tv_nsec / 1000000000.0f;
 #endif
 #endif
 }
 
-static uint64_t szmin(uint64_t a, uint64_t b)
+float CallaterCurrentTime()
 {
-    return a < b ? a : b;
+    return CallaterReadTime(false);
 }
 
-static void *CallaterAlignedAlloc(uint64_t size, unsigned char alignment, unsigned char *offset)
+// used while precise invocations are pending, see `CallaterSetPrecise`
+static float CallaterFineTime()
 {
-    void *ret = calloc(size + (alignment - 1), 1);
-    void *aligned = (void*)(((uintptr_t)ret + (alignment - 1)) & ~(alignment - 1));
-    *offset = (char*)aligned - (char*)ret;
-    return aligned;
+    return CallaterReadTime(true);
 }
 
-static void *CallaterAlignedRealloc(void *ptr, uint64_t size, uint64_t oldSize, unsigned char alignment, unsigned char *offset)
+#ifdef CALLATER_HAS_TSC
+
+// the TSC only ticks at a constant rate across cores and power states when it's invariant
+static bool CallaterTscInvariant()
 {
-    void *ret = realloc((unsigned char*)ptr - *offset, size + (alignment - 1));
-    void *aligned = (void*)(((uintptr_t)ret + (alignment - 1)) & ~(alignment - 1));
-    unsigned char newOffset = (char*)aligned - (char*)ret;
-    
-    if(newOffset != *offset)
-        memmove(aligned, (char*)ret + *offset, szmin(size, oldSize));
-    
-    *offset = newOffset;
-    return aligned;
+#ifdef _MSC_VER
+    int regs[4];
+    __cpuid(regs, 0x80000000);
+    if((unsigned)regs[0] < 0x80000007)
+        return false;
+    __cpuid(regs, 0x80000007);
+    return (regs[3] >> 8) & 1;
+#else
+    unsigned eax, ebx, ecx, edx;
+    if(__get_cpuid_max(0x80000000, NULL) < 0x80000007)
+        return false;
+    if(!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+        return false;
+    return (edx >> 8) & 1;
+#endif
 }
 
-void CallaterInit()
+// the fine OS clock in seconds, only read while calibrating
+static double CallaterFineSeconds()
 {
-    table = (CallaterTable){0};
 #ifdef _WIN32
-    QueryPerformanceFrequency((void*) &table.clockFreq);
+    uint64_t time;
+    QueryPerformanceCounter((void*)&time);
+    return (double)time / table.clockFreq;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
 #endif
-    table.startSec = CallaterCurrentTime();
-    // table.count  = 0;
-    table.cap    = 64;
-    table.funcs  = calloc(table.cap, sizeof(*table.funcs));
-    table.args   = calloc(table.cap, sizeof(*table.args));
-    table.invokeTimes = CallaterAlignedAlloc(table.cap * sizeof(*table.invokeTimes), 32, &table.delaysPtrOffset);
-    table.invokeData = malloc(table.cap * sizeof(*table.invokeData));
-    table.pausedInvokes.cap = 32;
-    table.pausedInvokes.pausedInvokes = malloc(table.pausedInvokes.cap * sizeof(*table.pausedInvokes.pausedInvokes));
-    
-    table.nextEmptySpot = 0;
-    table.count = 0;
-    table.minInvokeTime = INFINITY;
 }
 
-static void CallaterNoop(void *arg, CallaterRef ref)
+// counts the TSC ticks over `CALLATER_TSC_CALIBRATION` seconds of the OS clock
+// leaves `table.tscPeriod` at 0 (so the OS clock is used) if the TSC can't be trusted
+static void CallaterCalibrateTsc()
 {
-    (void)arg;
-    (void)ref;
+    table.tscPeriod = 0;
+    if(!CallaterTscInvariant())
+        return;
+    
+    const double start = CallaterFineSeconds();
+    const uint64_t tscStart = __rdtsc();
+    double end;
+    do
+    {
+        end = CallaterFineSeconds();
+    } while(end - start < CALLATER_TSC_CALIBRATION);
+    const uint64_t ticks = __rdtsc() - tscStart;
+    
+    if(ticks != 0)
+    {
+        table.tscStart = tscStart;
+        table.tscPeriod = (end - start) / ticks;
+        table.tscBase = start - table.startSec;
+    }
 }
 
-static void CallaterRemovePause(uint64_t index);
+#endif
 
-static void CallaterPopInvoke(uint64_t idx)
+// the time outside of `CallaterUpdate`, see `CallaterSetFrameTime`
+static float CallaterNow()
 {
-    table.noopCount += (table.funcs[idx] != CallaterNoop);
-    table.funcs[idx] = CallaterNoop;
-    table.args[idx] = NULL;
-    table.invokeTimes[idx] = INFINITY;
-    table.invokeData[idx].groupId = (uint64_t)-1;
-    table.invokeData[idx].repeatRate = INFINITY;
+    return table.frameTime || table.fixedStep ? table.lastUpdated : CallaterCurrentTime();
+}
+
+static uint64_t szmin(uint64_t a, uint64_t b)
+{
+    return a < b ? a : b;
+}
+
+static void *CallaterDefaultAlloc(uint64_t size, uint64_t alignment, void *user)
+{
+    (void)user;
+    if(alignment <= _Alignof(max_align_t))
+        return malloc(size);
+    return _mm_malloc(size, alignment);
+}
+
+static void *CallaterDefaultRealloc(void *ptr, uint64_t oldSize, uint64_t newSize, uint64_t alignment, void *user)
+{
+    (void)user;
+    if(alignment <= _Alignof(max_align_t))
+        return realloc(ptr, newSize);
     
-    if(table.invokeData[idx].pausedIndex != (uint64_t)-1)
-    {
-        CallaterRemovePause(table.invokeData[idx].pausedIndex);
-    }
+    void *ret = _mm_malloc(newSize, alignment);
+    if(ret == NULL)
+        return NULL;
+    memcpy(ret, ptr, szmin(oldSize, newSize));
+    _mm_free(ptr);
+    return ret;
 }
 
-static void CallaterReallocTable(uint64_t newCap)
+static void CallaterDefaultFree(void *ptr, uint64_t size, uint64_t alignment, void *user)
 {
-    table.funcs  = realloc(table.funcs,  newCap * sizeof(*table.funcs));
-    table.args   = realloc(table.args,   newCap * sizeof(*table.args));
-    table.invokeTimes =
-    CallaterAlignedRealloc(
-        table.invokeTimes,
-        newCap    * sizeof(*table.invokeTimes),
-        table.cap * sizeof(*table.invokeTimes),
-        32,
-        &table.delaysPtrOffset
-    );
-    table.invokeData = realloc(table.invokeData, newCap * sizeof(*table.invokeData));
-    table.cap = newCap;
+    (void)size;
+    (void)user;
+    if(alignment <= _Alignof(max_align_t))
+        free(ptr);
+    else
+        _mm_free(ptr);
 }
 
-static bool CallaterMaybeGrowTable()
+static const CallaterAllocator callaterDefaultAllocator = {
+    .alloc   = CallaterDefaultAlloc,
+    .realloc = CallaterDefaultRealloc,
+    .free    = CallaterDefaultFree,
+};
+
+#ifdef __linux__
+
+// big allocations are mapped directly and backed by transparent huge pages, so scanning
+// millions of slots touches a few TLB entries instead of thousands
+static void *CallaterHugePageAlloc(uint64_t size, uint64_t alignment, void *user)
 {
-    if(table.cap <= table.count)
-    {
-        const uint64_t newCap = table.cap * 2;
-        CallaterReallocTable(newCap);
-        return true;
-    }
-    return false;
+    if(size < CALLATER_HUGE_PAGE_THRESHOLD)
+        return CallaterDefaultAlloc(size, alignment, user);
+    
+    void *ret = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(ret == MAP_FAILED)
+        return NULL;
+    madvise(ret, size, MADV_HUGEPAGE);
+    return ret;
 }
 
-static void CallaterCallFunc(uint64_t idx, float curTime)
+static void CallaterHugePageFree(void *ptr, uint64_t size, uint64_t alignment, void *user)
 {
-    table.funcs[idx](table.args[idx], (CallaterRef){idx});
-    if(signbit(table.invokeData[idx].repeatRate))
-    {
-        CallaterPopInvoke(idx);
-    }
+    if(size < CALLATER_HUGE_PAGE_THRESHOLD)
+        CallaterDefaultFree(ptr, size, alignment, user);
     else
-    {
-        table.invokeTimes[idx] = curTime + table.invokeData[idx].repeatRate;
-    }
+        munmap(ptr, size);
 }
 
-static void CallaterFindNewLastInvocation(uint64_t startFrom)
+static void *CallaterHugePageRealloc(void *ptr, uint64_t oldSize, uint64_t newSize, uint64_t alignment, void *user)
 {
-    uint64_t lastInvoke = -1;
-    for(uint64_t i = startFrom ; i != (uint64_t)-1 ; i--)
+    if(oldSize < CALLATER_HUGE_PAGE_THRESHOLD && newSize < CALLATER_HUGE_PAGE_THRESHOLD)
+        return CallaterDefaultRealloc(ptr, oldSize, newSize, alignment, user);
+    
+#ifdef MREMAP_MAYMOVE
+    // both are mapped, the kernel moves the pages instead of copying them
+    if(oldSize >= CALLATER_HUGE_PAGE_THRESHOLD && newSize >= CALLATER_HUGE_PAGE_THRESHOLD)
     {
-        if(table.funcs[i] != CallaterNoop)
-        {
-            lastInvoke = i;
-            break;
-        }
+        void *ret = mremap(ptr, oldSize, newSize, MREMAP_MAYMOVE);
+        if(ret == MAP_FAILED)
+            return NULL;
+        madvise(ret, newSize, MADV_HUGEPAGE);
+        return ret;
     }
-    table.count = lastInvoke + 1;
+#endif
+    
+    // the old block stays valid when this fails
+    void *ret = CallaterHugePageAlloc(newSize, alignment, user);
+    if(ret == NULL)
+        return NULL;
+    memcpy(ret, ptr, szmin(oldSize, newSize));
+    CallaterHugePageFree(ptr, oldSize, alignment, user);
+    return ret;
 }
 
-static void CallaterFindNewMinInvokeTime()
+static const CallaterAllocator callaterHugePageAllocator = {
+    .alloc   = CallaterHugePageAlloc,
+    .realloc = CallaterHugePageRealloc,
+    .free    = CallaterHugePageFree,
+};
+
+#endif
+
+// bump allocator over `table.arena`, fixed tables allocate everything once in `CallaterInitFixed`
+static void *CallaterArenaAlloc(uint64_t size, uint64_t alignment, void *user)
 {
-    float newMinInvokeTime = INFINITY;
-    for(uint64_t i = 0 ; i < table.count ; i++)
+    CallaterArena *arena = user;
+    uintptr_t at = ((uintptr_t)arena->cursor + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    if(at + size > (uintptr_t)arena->end)
+        return NULL;
+    arena->cursor = (unsigned char*)at + size;
+    return (void*)at;
+}
+
+static void *CallaterArenaRealloc(void *ptr, uint64_t oldSize, uint64_t newSize, uint64_t alignment, void *user)
+{
+    (void)ptr; (void)oldSize; (void)newSize; (void)alignment; (void)user;
+    // fixed tables never grow
+    return NULL;
+}
+
+static void CallaterArenaFree(void *ptr, uint64_t size, uint64_t alignment, void *user)
+{
+    (void)ptr; (void)size; (void)alignment; (void)user;
+}
+
+const CallaterAllocator *CallaterHugePageAllocator()
+{
+#ifdef __linux__
+    return &callaterHugePageAllocator;
+#else
+    return &callaterDefaultAllocator;
+#endif
+}
+
+#ifdef CALLATER_HAS_VIRTUAL_MEMORY
+
+static uint64_t CallaterPageSize()
+{
+    static uint64_t pageSize = 0;
+    if(pageSize == 0)
     {
-        if(table.invokeTimes[i] < newMinInvokeTime)
-        {
-            newMinInvokeTime = table.invokeTimes[i];
-        }
+#ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        pageSize = info.dwPageSize;
+#else
+        pageSize = sysconf(_SC_PAGESIZE);
+#endif
     }
-    table.minInvokeTime = newMinInvokeTime;
+    return pageSize;
 }
 
-static void CallaterTick(float curTime)
+static uint64_t CallaterPageRound(uint64_t size)
 {
-    const __m256 curTimeVec = _mm256_set1_ps(curTime);
-    
-    uint64_t i;
-    for(i = 0 ; i + 7 < table.count ; i += 8)
+    uint64_t pageSize = CallaterPageSize();
+    return (size + pageSize - 1) / pageSize * pageSize;
+}
+
+// arrays of `CallaterInitVirtual` tables: `reserveSize` bytes of address space are reserved on the first call
+// and only the pages under `newSize` are committed, so growing never copies and the array never moves
+// releases the reservation when `newSize` is 0. Returns false, with the array as it was, if reserving or committing failed
+static bool CallaterVirtualResize(void **ptr, uint64_t oldSize, uint64_t newSize, uint64_t reserveSize)
+{
+    reserveSize = CallaterPageRound(reserveSize);
+    const bool reserved = *ptr != NULL;
+    if(!reserved)
     {
-        __m256 tableDelaysVec = _mm256_load_ps(table.invokeTimes + i);
-        __m256 results = _mm256_cmp_ps(curTimeVec, tableDelaysVec, _CMP_GE_OQ);
-        
-        int mask = _mm256_movemask_ps(results);
-        while (mask != 0)
-        {
-            unsigned long bit;
+        if(newSize == 0)
+            return true;
 #ifdef _WIN32
-            _BitScanForward(&bit, mask);
+        void *base = VirtualAlloc(NULL, reserveSize, MEM_RESERVE, PAGE_NOACCESS);
+        if(base == NULL)
+            return false;
 #else
-            bit = __builtin_ctz(mask);
+        void *base = mmap(NULL, reserveSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if(base == MAP_FAILED)
+            return false;
 #endif
-            mask &= ~(1 << bit);
-            CallaterCallFunc(i + bit, curTime);
-        }
+        *ptr = base;
+        oldSize = 0;
+    }
+    if(newSize == 0)
+    {
+#ifdef _WIN32
+        VirtualFree(*ptr, 0, MEM_RELEASE);
+#else
+        munmap(*ptr, reserveSize);
+#endif
+        *ptr = NULL;
+        return true;
     }
     
-    const int remaining = table.count - i;
-    
-    for(int j = 0 ; j < remaining ; j++)
+    unsigned char *base = *ptr;
+    uint64_t oldCommit = CallaterPageRound(oldSize);
+    uint64_t newCommit = CallaterPageRound(newSize);
+    if(newCommit > oldCommit)
     {
-        if(table.invokeTimes[j + i] <= curTime)
+#ifdef _WIN32
+        const bool committed = VirtualAlloc(base + oldCommit, newCommit - oldCommit, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+        const bool committed = mprotect(base + oldCommit, newCommit - oldCommit, PROT_READ | PROT_WRITE) == 0;
+#endif
+        if(!committed)
         {
-            CallaterCallFunc(j + i, curTime);
+            // a reservation made by this call goes away with it
+            if(!reserved)
+                CallaterVirtualResize(ptr, 0, 0, reserveSize);
+            return false;
         }
     }
-    
-    CallaterFindNewMinInvokeTime();
-    
-    if(table.funcs[table.count - 1] == CallaterNoop)
+    else if(newCommit < oldCommit)
     {
-        CallaterFindNewLastInvocation(table.count - 1);
+        // give the pages back to the OS but keep the addresses reserved
+#ifdef _WIN32
+        VirtualFree(base + newCommit, oldCommit - newCommit, MEM_DECOMMIT);
+#else
+        madvise(base + newCommit, oldCommit - newCommit, MADV_DONTNEED);
+        mprotect(base + newCommit, oldCommit - newCommit, PROT_NONE);
+#endif
     }
+    return true;
 }
 
-void CallaterUpdate()
+#endif
+
+// allocates when `ptr` is NULL, frees when `newSize` is 0
+static void *CallaterResize(void *ptr, uint64_t oldSize, uint64_t newSize, uint64_t alignment)
 {
-    float curTime = CallaterCurrentTime();
-    table.lastUpdated = curTime;
-    
-    // do we even need the second term? minInvokeTime should be enough
-    if(curTime < table.minInvokeTime || table.count == 0)
+    CallaterAllocator *allocator = &table.allocator;
+    if(newSize == 0)
     {
-        return;
+        if(ptr != NULL)
+            allocator->free(ptr, oldSize, alignment, allocator->user);
+        return NULL;
     }
-    
-    CallaterTick(curTime);
+    if(ptr == NULL)
+    {
+        return allocator->alloc(newSize, alignment, allocator->user);
+    }
+    return allocator->realloc(ptr, oldSize, newSize, alignment, allocator->user);
 }
 
-CallaterRef CallaterInvoke(void(*func)(void*, CallaterRef), void* arg, float delay)
+// `*ptr` is only replaced when the allocation worked, so the old block is still there (and owned by the caller) when it returns false
+static bool CallaterResizeArray(void **ptr, uint64_t oldSize, uint64_t newSize, uint64_t alignment)
 {
-    return CallaterInvokeGID(func, arg, delay, (uint64_t)-1);
+    void *ret = CallaterResize(*ptr, oldSize, newSize, alignment);
+    if(ret == NULL && newSize != 0)
+        return false;
+    *ptr = ret;
+    return true;
 }
 
-CallaterRef CallaterInvokeGID(void(*func)(void*, CallaterRef), void *arg, float delay, uint64_t groupId)
+#define CALLATER_RESIZE_ARRAY(ptr, oldCount, newCount, alignment) \
+CallaterResizeArray((void**)&(ptr), (oldCount) * sizeof(*(ptr)), (newCount) * sizeof(*(ptr)), (alignment))
+
+// one of the arrays that have `table.cap` elements
+typedef struct CallaterTableArray
 {
-    if(table.nextEmptySpot == (uint64_t)-1)
+    void **ptr;
+    uint64_t elemSize;
+    uint64_t alignment;
+} CallaterTableArray;
+
+static bool CallaterResizeTableArray(CallaterTableArray array, uint64_t oldCap, uint64_t newCap)
+{
+#ifdef CALLATER_HAS_VIRTUAL_MEMORY
+    if(table.maxCap != 0)
+        return CallaterVirtualResize(array.ptr, oldCap * array.elemSize, newCap * array.elemSize, table.maxCap * array.elemSize);
+#endif
+    return CallaterResizeArray(array.ptr, oldCap * array.elemSize, newCap * array.elemSize, array.alignment);
+}
+
+// the arrays indexed by slot have `table.cap` elements, the stores grow by how many invocations they hold
+// either all of them are resized or none is, returns false if an allocation failed
+static bool CallaterResizeTableArrays(uint64_t oldCap, uint64_t newCap)
+{
+    const CallaterTableArray arrays[] = {
+        {(void**)&table.funcs,       sizeof(*table.funcs),       _Alignof(typeof(*table.funcs))},
+        {(void**)&table.args,        sizeof(*table.args),        _Alignof(typeof(*table.args))},
+        {(void**)&table.invokeTimes, sizeof(*table.invokeTimes), _Alignof(typeof(*table.invokeTimes))},
+        {(void**)&table.invokeData,  sizeof(*table.invokeData),  _Alignof(typeof(*table.invokeData))},
+    };
+    
+    for(uint64_t i = 0 ; i < sizeof(arrays) / sizeof(*arrays) ; i++)
+    {
+        // a shrink that fails leaves the array bigger than it needs to be, which is harmless
+        if(!CallaterResizeTableArray(arrays[i], oldCap, newCap) && newCap > oldCap)
+        {
+            // the ones already grown go back, so the table is left as it was
+            while(i-- > 0)
+            {
+                CallaterResizeTableArray(arrays[i], newCap, oldCap);
+            }
+            return false;
+        }
+    }
+    table.cap = newCap;
+    return true;
+}
+
+// the most invocations the table can ever hold
+static uint64_t CallaterCapLimit()
+{
+    if(table.fixed)
+        return table.cap;
+    if(table.maxCap != 0)
+        return table.maxCap;
+    // the last index is `CALLATER_REF_ERR`
+    return CALLATER_NO_SLOT;
+}
+
+// the capacity a store grows to when it needs `needed` entries: doubled, so inserts stay amortized O(1),
+// but never more than the table can hold invocations
+static uint64_t CallaterGrowCap(uint64_t cap, uint64_t needed)
+{
+    const uint64_t newCap = szmin(cap == 0 ? 16 : cap * 2, CallaterCapLimit());
+    return newCap < needed ? needed : newCap;
+}
+
+// a shrink that fails leaves the array bigger than it needs to be, which is harmless
+static bool CallaterHotResize(uint64_t newCap)
+{
+    CallaterHotArray *hot = &table.hot;
+    if(!CALLATER_RESIZE_ARRAY(hot->invokeTimes, hot->cap, newCap, 32) && newCap > hot->cap)
+        return false;
+    if(!CALLATER_RESIZE_ARRAY(hot->slots, hot->cap, newCap, _Alignof(CallaterIndex)) && newCap > hot->cap)
+    {
+        CALLATER_RESIZE_ARRAY(hot->invokeTimes, newCap, hot->cap, 32);
+        return false;
+    }
+    hot->cap = newCap;
+    return true;
+}
+
+// makes room for `n` more lanes, returns false if the hot array can't grow
+static bool CallaterHotReserve(uint64_t n)
+{
+    return table.hot.count + n <= table.hot.cap || CallaterHotResize(CallaterGrowCap(table.hot.cap, table.hot.count + n));
+}
+
+static bool CallaterFarResize(CallaterFarStore *heap, uint64_t newCap)
+{
+    if(!CALLATER_RESIZE_ARRAY(heap->invokes, heap->cap, newCap, _Alignof(CallaterFarInvoke)) && newCap > heap->cap)
+        return false;
+    heap->cap = newCap;
+    return true;
+}
+
+// makes room for `n` more invocations in `table.far` or a clock heap, returns false if it can't grow
+static bool CallaterFarReserve(CallaterFarStore *heap, uint64_t n)
+{
+    return heap->count + n <= heap->cap || CallaterFarResize(heap, CallaterGrowCap(heap->cap, heap->count + n));
+}
+
+static bool CallaterDueResize(uint64_t newCap)
+{
+    if(!CALLATER_RESIZE_ARRAY(table.dueSlots, table.dueCap, newCap, _Alignof(CallaterIndex)) && newCap > table.dueCap)
+        return false;
+    table.dueCap = newCap;
+    return true;
+}
+
+// makes room for `n` due invocations in `table.dueSlots`. When it can't grow the due invocations it has no room for
+// stay in their stores and are found again by the next update
+static bool CallaterDueReserve(uint64_t n)
+{
+    return n <= table.dueCap || CallaterDueResize(CallaterGrowCap(table.dueCap, n));
+}
+
+// returns false if the first allocation failed, the table is still usable and tries again when an invocation is added
+static bool CallaterInitTable(const CallaterAllocator *allocator, uint64_t cap)
+{
+    table.allocator = *allocator;
+#ifdef _WIN32
+    QueryPerformanceFrequency((void*) &table.clockFreq);
+#endif
+    table.startSec = CallaterCurrentTime();
+#ifdef CALLATER_HAS_TSC
+    CallaterCalibrateTsc();
+#endif
+    // table.count  = 0;
+    const bool allocated = CallaterResizeTableArrays(0, cap);
+    
+    // with no arrays yet the first insert grows the table
+    table.nextEmptySpot = allocated ? 0 : (uint64_t)-1;
+    table.count = 0;
+    table.minInvokeTime = INFINITY;
+    table.horizon = CALLATER_DEFAULT_HORIZON;
+    table.engine = CALLATER_ENGINE_ADAPTIVE;
+    table.backend = &callaterLinearBackend;
+    table.clocks[0] = (CallaterClockState){.scale = 1, .alive = true};
+#ifndef CALLATER_NO_REPEAT
+    table.missedSlot = CALLATER_NO_SLOT;
+#endif
+    table.clockCount = 1;
+    table.deferNext.store = CALLATER_STORE_NEXT_UPDATE;
+    table.deferEndOfUpdate.store = CALLATER_STORE_END_OF_UPDATE;
+    table.defaultSlackExp = CALLATER_NO_SLACK;
+    memset(table.laneBudgets, 0xff, sizeof(table.laneBudgets));
+    return allocated;
+}
+
+void CallaterInit()
+{
+    CallaterInitEx(&callaterDefaultAllocator);
+}
+
+void CallaterInitEx(const CallaterAllocator *allocator)
+{
+    table = (CallaterTable){0};
+    CallaterInitTable(allocator, 64);
+}
+
+// what every slot of a fixed table takes, it has room for each invocation in every store
+static uint64_t CallaterFixedSlotSize()
+{
+    return sizeof(*table.funcs) + sizeof(*table.args) + sizeof(*table.invokeTimes) + sizeof(*table.invokeData) +
+           sizeof(*table.hot.invokeTimes) + sizeof(*table.hot.slots) + sizeof(*table.far.invokes) + sizeof(*table.dueSlots);
+}
+
+uint64_t CallaterFixedBufferSize(uint64_t capacity)
+{
+    const uint64_t slotSize = CallaterFixedSlotSize();
+#ifdef CALLATER_COMPACT_ARGS
+    // no `CallaterInvokeCopy`, so no payloads
+    const uint64_t blocks = 0;
+#else
+    const uint64_t blocks = (capacity + CALLATER_PAYLOAD_BLOCK - 1) / CALLATER_PAYLOAD_BLOCK;
+#endif
+    const uint64_t blockSize = sizeof(unsigned char*) + CALLATER_PAYLOAD_BLOCK * CALLATER_PAYLOAD_SIZE;
+    // worst case padding to align the 9 arrays and every payload block
+    const uint64_t padding = 9 * 32 + blocks * _Alignof(max_align_t);
+    return capacity * slotSize + blocks * blockSize + padding;
+}
+
+#ifndef CALLATER_COMPACT_ARGS
+static void *CallaterPayloadOf(uint64_t idx);
+#endif
+
+uint64_t CallaterInitFixed(void *buffer, uint64_t size)
+{
+    table = (CallaterTable){0};
+    
+    // biggest capacity whose arrays fit in `size` bytes, the slots alone already can't take more than all of it
+    uint64_t lo = 0, hi = size / CallaterFixedSlotSize();
+    while(lo < hi)
+    {
+        uint64_t mid = lo + (hi - lo + 1) / 2;
+        if(CallaterFixedBufferSize(mid) <= size)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    if(lo == 0)
+        return 0;
+    
+    table.fixed = true;
+    table.arena = (CallaterArena){.cursor = buffer, .end = (unsigned char*)buffer + size};
+    const CallaterAllocator arenaAllocator = {
+        .alloc   = CallaterArenaAlloc,
+        .realloc = CallaterArenaRealloc,
+        .free    = CallaterArenaFree,
+        .user    = &table.arena,
+    };
+    CallaterInitTable(&arenaAllocator, lo);
+    // the stores can't grow later, so they get room for every slot
+    CallaterHotResize(lo);
+    CallaterFarResize(&table.far, lo);
+    CallaterDueResize(lo);
+    
+#ifndef CALLATER_COMPACT_ARGS
+    // the payloads are carved out up front too, so `CallaterInvokeCopy` doesn't allocate later
+    CallaterPayloadOf(lo - 1);
+    for(uint64_t i = 0 ; i < lo ; i += CALLATER_PAYLOAD_BLOCK)
+    {
+        CallaterPayloadOf(i);
+    }
+#endif
+    return lo;
+}
+
+bool CallaterInitVirtual(uint64_t maxCapacity)
+{
+#ifdef CALLATER_HAS_VIRTUAL_MEMORY
+    if(maxCapacity == 0)
+        return false;
+    
+    table = (CallaterTable){0};
+    table.maxCap = maxCapacity;
+    // the address space is reserved here, so running out of it shows up now rather than on some later insert
+    if(!CallaterInitTable(&callaterDefaultAllocator, szmin(64, maxCapacity)))
+    {
+        table = (CallaterTable){0};
+        return false;
+    }
+    return true;
+#else
+    (void)maxCapacity;
+    return false;
+#endif
+}
+
+static void CallaterNoop(void *arg, CallaterRef ref)
+{
+    (void)arg;
+    (void)ref;
+}
+
+#ifndef CALLATER_NO_PAUSE
+
+// a paused slot keeps its remaining delay in its own time lane, negated so the sign bit tags it
+// overdue invocations are paused with no delay left, -0.0f
+static float CallaterPausedTime(float delay)
+{
+    return -fmaxf(delay, 0.0f);
+}
+
+static float CallaterPausedDelay(float pausedTime)
+{
+    return -pausedTime;
+}
+
+#endif
+
+static void CallaterHotInsert(uint64_t idx, float invokeTime)
+{
+    CallaterHotArray *hot = &table.hot;
+    uint64_t lane = hot->count;
+    hot->invokeTimes[lane] = invokeTime;
+    hot->slots[lane] = idx;
+    hot->count += 1;
+    table.invokeData[idx].store = CALLATER_STORE_HOT;
+    table.invokeData[idx].storeIndex = lane;
+}
+
+static void CallaterHotRemove(uint64_t lane)
+{
+    CallaterHotArray *hot = &table.hot;
+    hot->count -= 1;
+    if(lane != hot->count)
+    {
+        hot->invokeTimes[lane] = hot->invokeTimes[hot->count];
+        hot->slots[lane] = hot->slots[hot->count];
+        table.invokeData[hot->slots[lane]].storeIndex = lane;
+    }
+}
+
+static void CallaterFarSet(CallaterFarStore *heap, uint64_t pos, CallaterFarInvoke invoke)
+{
+    heap->invokes[pos] = invoke;
+    table.invokeData[invoke.slot].storeIndex = pos;
+}
+
+static void CallaterFarSiftUp(CallaterFarStore *heap, uint64_t pos)
+{
+    CallaterFarInvoke invoke = heap->invokes[pos];
+    while(pos > 0)
+    {
+        uint64_t parent = (pos - 1) / 2;
+        if(heap->invokes[parent].invokeTime <= invoke.invokeTime)
+            break;
+        CallaterFarSet(heap, pos, heap->invokes[parent]);
+        pos = parent;
+    }
+    CallaterFarSet(heap, pos, invoke);
+}
+
+static void CallaterFarSiftDown(CallaterFarStore *heap, uint64_t pos)
+{
+    CallaterFarInvoke invoke = heap->invokes[pos];
+    for(;;)
+    {
+        uint64_t child = pos * 2 + 1;
+        if(child >= heap->count)
+            break;
+        if(child + 1 < heap->count && heap->invokes[child + 1].invokeTime < heap->invokes[child].invokeTime)
+            child += 1;
+        if(invoke.invokeTime <= heap->invokes[child].invokeTime)
+            break;
+        CallaterFarSet(heap, pos, heap->invokes[child]);
+        pos = child;
+    }
+    CallaterFarSet(heap, pos, invoke);
+}
+
+// the caller sets the store of the slot, `table.far` and the clock heaps share this
+static void CallaterFarInsert(CallaterFarStore *heap, uint64_t idx, float invokeTime)
+{
+    uint64_t pos = heap->count;
+    heap->count += 1;
+    heap->invokes[pos] = (CallaterFarInvoke){.slot = idx, .invokeTime = invokeTime};
+    CallaterFarSiftUp(heap, pos);
+}
+
+static void CallaterFarRemove(CallaterFarStore *heap, uint64_t pos)
+{
+    heap->count -= 1;
+    if(pos != heap->count)
+    {
+        uint64_t moved = heap->invokes[heap->count].slot;
+        CallaterFarSet(heap, pos, heap->invokes[heap->count]);
+        CallaterFarSiftDown(heap, pos);
+        CallaterFarSiftUp(heap, table.invokeData[moved].storeIndex);
+    }
+}
+
+static void CallaterFarPush(uint64_t idx, float invokeTime)
+{
+    table.invokeData[idx].store = CALLATER_STORE_FAR;
+    CallaterFarInsert(&table.far, idx, invokeTime);
+}
+
+static bool CallaterClockValid(CallaterClock clock)
+{
+    return clock.id < CALLATER_MAX_CLOCKS && table.clocks[clock.id].alive;
+}
+
+#if !defined(CALLATER_NO_REPEAT) || !defined(CALLATER_NO_PAUSE)
+
+// the time invocations on `clock` are scheduled against, `curTime` for the global clock
+static float CallaterClockNow(uint64_t clock, float curTime)
+{
+    return clock == 0 ? curTime : table.clocks[clock].time;
+}
+
+#endif
+
+// how fast `clock` runs compared to real time, 0 if it or one of its ancestors is paused
+static float CallaterClockRate(uint64_t clock)
+{
+    float rate = 1;
+    for( ; clock != 0 ; clock = table.clocks[clock].parent)
+    {
+        rate *= table.clocks[clock].paused ? 0 : table.clocks[clock].scale;
+    }
+    return rate;
+}
+
+// whether `clock` or one of its ancestors is paused, its invocations aren't called then even if they're due
+static bool CallaterClockHalted(uint64_t clock)
+{
+    for( ; clock != 0 ; clock = table.clocks[clock].parent)
+    {
+        if(table.clocks[clock].paused)
+            return true;
+    }
+    return false;
+}
+
+static bool CallaterClockPush(uint64_t idx, float invokeTime)
+{
+    CallaterClockState *clock = &table.clocks[table.invokeData[idx].clock];
+    if(!CallaterFarReserve(&clock->heap, 1))
+        return false;
+    table.invokeData[idx].store = CALLATER_STORE_CLOCK;
+    CallaterFarInsert(&clock->heap, idx, invokeTime);
+    return true;
+}
+
+#ifndef CALLATER_NO_REPEAT
+
+static void CallaterCohortPush(uint64_t cohortIdx, uint64_t idx)
+{
+    CallaterCohort *cohort = &table.cohorts[cohortIdx];
+    table.invokeData[idx].store = CALLATER_STORE_COHORT;
+    table.invokeData[idx].cohort = cohortIdx;
+    table.invokeData[idx].next = CALLATER_NO_SLOT;
+    if(cohort->count == 0)
+    {
+        table.invokeData[idx].storeIndex = CALLATER_NO_SLOT;
+        cohort->first = idx;
+    }
+    else
+    {
+        table.invokeData[idx].storeIndex = cohort->last;
+        table.invokeData[cohort->last].next = idx;
+    }
+    cohort->last = idx;
+    cohort->count += 1;
+}
+
+static void CallaterCohortRemove(uint64_t idx)
+{
+    CallaterCohort *cohort = &table.cohorts[table.invokeData[idx].cohort];
+    CallaterIndex prev = table.invokeData[idx].storeIndex;
+    CallaterIndex next = table.invokeData[idx].next;
+    
+    if(prev == CALLATER_NO_SLOT)
+        cohort->first = next;
+    else
+        table.invokeData[prev].next = next;
+    
+    if(next == CALLATER_NO_SLOT)
+        cohort->last = prev;
+    else
+        table.invokeData[next].storeIndex = prev;
+    
+    cohort->count -= 1;
+}
+
+// returns the cohort for `repeatRate`, reusing an empty one if none exists yet
+// returns -1 if every cohort is taken
+static uint64_t CallaterFindCohort(float repeatRate)
+{
+    uint64_t emptyCohort = (uint64_t)-1;
+    for(uint64_t i = 0 ; i < CALLATER_MAX_COHORTS ; i++)
+    {
+        if(table.cohorts[i].count == 0)
+        {
+            emptyCohort = (emptyCohort == (uint64_t)-1 ? i : emptyCohort);
+        }
+        else if(table.cohorts[i].repeatRate == repeatRate)
+        {
+            return i;
+        }
+    }
+    
+    if(emptyCohort != (uint64_t)-1)
+    {
+        table.cohorts[emptyCohort].repeatRate = repeatRate;
+    }
+    return emptyCohort;
+}
+
+#endif
+
+// the fields a new invocation starts with, on top of its func, arg, group and repeat rate
+static void CallaterResetExtras(CallaterInvokeData *data)
+{
+    data->clock = 0;
+    data->precise = false;
+    data->priority = 0;
+    data->slackExp = table.defaultSlackExp;
+    data->frames = false;
+}
+
+// rounds `invokeTime` up to the grid of the slack of the slot, invocations rounded to the same grid point get called by
+// the same update. The grid is a power of two no bigger than the slack, so it never delays by more
+static float CallaterAlignSlack(uint64_t idx, float invokeTime)
+{
+    const int8_t slackExp = table.invokeData[idx].slackExp;
+    if(slackExp == CALLATER_NO_SLACK)
+        return invokeTime;
+    const double grid = ldexp(1.0, slackExp);
+    return ceil(invokeTime / grid) * grid;
+}
+
+// `table.invokeTimes` keeps the time the invocation asked for, so repeats don't add up the slack
+// the stores and `table.minInvokeTime` hold this one, the time it's actually called at
+static float CallaterDueTime(uint64_t idx)
+{
+    return CallaterAlignSlack(idx, table.invokeTimes[idx]);
+}
+
+static void CallaterPopInvoke(uint64_t idx);
+
+static void CallaterSchedule(uint64_t idx, float nominalTime)
+{
+    table.invokeTimes[idx] = nominalTime;
+    const float invokeTime = CallaterDueTime(idx);
+    // `table.minInvokeTime` is in real time, it only covers the global clock
+    if(table.invokeData[idx].clock != 0)
+    {
+        // inserts make room first, so only a reschedule can get here without memory for it. It's dropped
+        if(!CallaterClockPush(idx, invokeTime))
+        {
+            CallaterPopInvoke(idx);
+        }
+        return;
+    }
+    if(!table.backend->schedule(idx, invokeTime))
+    {
+        CallaterPopInvoke(idx);
+        return;
+    }
+    
+    if(invokeTime < table.minInvokeTime)
+    {
+        table.minInvokeTime = invokeTime;
+    }
+}
+
+#ifndef CALLATER_NO_REPEAT
+
+// reschedules a repeating invocation at the back of the cohort for its repeat rate
+// falls back to `CallaterSchedule` when there's no cohort left, the FIFO order would break or it's on a child clock
+static void CallaterScheduleRepeat(uint64_t idx, float nominalTime)
+{
+    const float invokeTime = CallaterAlignSlack(idx, nominalTime);
+    uint64_t cohortIdx = table.invokeData[idx].clock == 0 ? CallaterFindCohort(table.invokeData[idx].repeatRate) : (uint64_t)-1;
+    if(cohortIdx == (uint64_t)-1 ||
+       (table.cohorts[cohortIdx].count != 0 && invokeTime < CallaterDueTime(table.cohorts[cohortIdx].last)))
+    {
+        CallaterSchedule(idx, nominalTime);
+        return;
+    }
+    
+    table.invokeTimes[idx] = nominalTime;
+    CallaterCohortPush(cohortIdx, idx);
+    if(invokeTime < table.minInvokeTime)
+    {
+        table.minInvokeTime = invokeTime;
+    }
+}
+
+#endif
+
+// removes the invocation from wherever it's stored, without freeing its slot
+static void CallaterUnschedule(uint64_t idx)
+{
+    uint64_t storeIndex = table.invokeData[idx].storeIndex;
+    switch(table.invokeData[idx].store)
+    {
+        case CALLATER_STORE_HOT:
+            CallaterHotRemove(storeIndex);
+            break;
+        case CALLATER_STORE_FAR:
+            CallaterFarRemove(&table.far, storeIndex);
+            break;
+#ifndef CALLATER_NO_REPEAT
+        case CALLATER_STORE_COHORT:
+            CallaterCohortRemove(idx);
+            break;
+#endif
+        case CALLATER_STORE_CLOCK:
+            CallaterFarRemove(&table.clocks[table.invokeData[idx].clock].heap, storeIndex);
+            break;
+        case CALLATER_STORE_FRAME:
+            // its entry in the wheel goes stale
+            table.frameCount -= 1;
+            break;
+        default:
+            break;
+    }
+    table.invokeData[idx].store = CALLATER_STORE_NONE;
+}
+
+static void CallaterPopInvoke(uint64_t idx)
+{
+    CallaterUnschedule(idx);
+    table.noopCount += (table.funcs[idx] != CallaterNoop);
+    table.funcs[idx] = CallaterNoop;
+    table.args[idx] = CALLATER_ARG_PACK(NULL);
+    table.invokeTimes[idx] = INFINITY;
+    CALLATER_SET_GROUP(table.invokeData[idx], CALLATER_NO_GROUP);
+    CALLATER_SET_REPEAT(table.invokeData[idx], INFINITY);
+    CALLATER_SET_POLICY(table.invokeData[idx], CALLATER_REPEAT_DELAY);
+    table.preciseCount -= table.invokeData[idx].precise;
+    CallaterResetExtras(&table.invokeData[idx]);
+}
+
+static bool CallaterReallocTable(uint64_t newCap)
+{
+    return CallaterResizeTableArrays(table.cap, newCap);
+}
+
+bool CallaterReserve(uint64_t n)
+{
+    if(n > CallaterCapLimit())
+        return false;
+    if(n > table.cap && !CallaterReallocTable(n))
+        return false;
+    // and room for all of them in the stores and the due list, so scheduling and calling them doesn't allocate either
+    return CallaterHotReserve(n - szmin(n, table.hot.count)) &&
+           CallaterFarReserve(&table.far, n - szmin(n, table.far.count)) &&
+           CallaterDueReserve(n);
+}
+
+// returns false if the table is full and can't grow
+static bool CallaterMaybeGrowTable()
+{
+    if(table.cap <= table.count)
+    {
+        const uint64_t newCap = szmin(table.cap == 0 ? 64 : table.cap * 2, CallaterCapLimit());
+        return newCap > table.cap && CallaterReallocTable(newCap);
+    }
+    return true;
+}
+
+#ifndef CALLATER_NO_REPEAT
+
+// whole periods a fixed rate invocation is late by, on top of the one that's due. Always 0 with `CALLATER_REPEAT_DELAY`
+static uint64_t CallaterMissedPeriods(uint64_t idx, float now)
+{
+    const float rate = table.invokeData[idx].repeatRate;
+    if(table.invokeData[idx].repeatPolicy == CALLATER_REPEAT_DELAY || signbit(rate) || rate == 0)
+        return 0;
+    const float late = now - table.invokeTimes[idx];
+    return late < rate ? 0 : (uint64_t)(late / rate);
+}
+
+// fixed rate invocations stay on the grid of their first invoke time, so lateness never adds up
+// either way the delay its own slack added isn't counted
+static float CallaterNextRepeat(uint64_t idx, float now, uint64_t missed)
+{
+    const float rate = table.invokeData[idx].repeatRate;
+    if(table.invokeData[idx].repeatPolicy == CALLATER_REPEAT_DELAY || rate == 0)
+        return now - (CallaterDueTime(idx) - table.invokeTimes[idx]) + rate;
+    return table.invokeTimes[idx] + rate * (missed + 1);
+}
+
+#endif
+
+static void CallaterCallFunc(uint64_t idx, float curTime)
+{
+    uint64_t calls = 1;
+#ifndef CALLATER_NO_REPEAT
+    const float now = CallaterClockNow(table.invokeData[idx].clock, curTime);
+    const uint64_t missed = CallaterMissedPeriods(idx, now);
+    switch(table.invokeData[idx].repeatPolicy)
+    {
+        case CALLATER_REPEAT_SKIP:
+            if(missed != 0)
+            {
+                CallaterScheduleRepeat(idx, CallaterNextRepeat(idx, now, missed));
+                return;
+            }
+            break;
+        case CALLATER_REPEAT_CATCH_UP:
+            calls += missed;
+            break;
+        case CALLATER_REPEAT_COALESCE:
+            table.missedSlot = idx;
+            table.missed = missed;
+            break;
+        default:
+            break;
+    }
+#else
+    (void)curTime;
+#endif
+    
+    do
+    {
+        table.funcs[idx](CALLATER_ARG_UNPACK(table.args[idx]), (CallaterRef){idx});
+#ifndef CALLATER_NO_REPEAT
+        // only valid inside the callback, the slot may be reused as soon as it returns
+        table.missedSlot = CALLATER_NO_SLOT;
+#endif
+        
+        // the callback cancelled, paused or rescheduled its own invocation
+        if(table.invokeData[idx].store != CALLATER_STORE_DUE)
+        {
+            return;
+        }
+    } while(--calls != 0);
+    
+#ifndef CALLATER_NO_REPEAT
+    if(!signbit(table.invokeData[idx].repeatRate))
+    {
+        CallaterScheduleRepeat(idx, CallaterNextRepeat(idx, now, missed));
+        return;
+    }
+#endif
+    CallaterPopInvoke(idx);
+}
+
+static void CallaterFindNewLastInvocation(uint64_t startFrom)
+{
+    uint64_t lastInvoke = -1;
+    for(uint64_t i = startFrom ; i != (uint64_t)-1 ; i--)
+    {
+        if(table.funcs[i] != CallaterNoop)
+        {
+            lastInvoke = i;
+            break;
+        }
+    }
+    table.count = lastInvoke + 1;
+}
+
+static void CallaterFindNewMinInvokeTime()
+{
+    float newMinInvokeTime = table.backend->minInvokeTime();
+#ifndef CALLATER_NO_REPEAT
+    for(uint64_t i = 0 ; i < CALLATER_MAX_COHORTS ; i++)
+    {
+        if(table.cohorts[i].count != 0 && CallaterDueTime(table.cohorts[i].first) < newMinInvokeTime)
+        {
+            newMinInvokeTime = CallaterDueTime(table.cohorts[i].first);
+        }
+    }
+#endif
+    table.minInvokeTime = newMinInvokeTime;
+}
+
+// puts the invocation in the hot array if it's due within the horizon, otherwise in the far store
+// if that one can't grow it goes in the other one, the far store promotes it once the hot array has room again
+static bool CallaterLinearSchedule(uint64_t idx, float invokeTime)
+{
+    bool hot = invokeTime - table.lastUpdated <= table.horizon;
+    if(!(hot ? CallaterHotReserve(1) : CallaterFarReserve(&table.far, 1)))
+    {
+        hot = !hot;
+    }
+    
+    if(hot)
+    {
+        if(!CallaterHotReserve(1))
+            return false;
+        CallaterHotInsert(idx, invokeTime);
+    }
+    else
+    {
+        if(!CallaterFarReserve(&table.far, 1))
+            return false;
+        CallaterFarPush(idx, invokeTime);
+    }
+    return true;
+}
+
+// moves everything that became due within the horizon from the far store to the hot array, as long as it has room
+static void CallaterLinearAdvance(float curTime)
+{
+    const float promoteUntil = curTime + table.horizon;
+    while(table.far.count != 0 && table.far.invokes[0].invokeTime <= promoteUntil && CallaterHotReserve(1))
+    {
+        CallaterFarInvoke invoke = table.far.invokes[0];
+        CallaterFarRemove(&table.far, 0);
+        CallaterHotInsert(invoke.slot, invoke.invokeTime);
+    }
+}
+
+static uint64_t CallaterLinearCollectDue(float curTime, uint64_t dueCount)
+{
+    const __m256 curTimeVec = _mm256_set1_ps(curTime);
+    const float *hotTimes = table.hot.invokeTimes;
+    uint64_t hotCount = table.hot.count;
+    const uint64_t firstDue = dueCount;
+    
+    uint64_t i;
+    for(i = 0 ; i + 7 < hotCount ; i += 8)
+    {
+        __m256 tableDelaysVec = _mm256_load_ps(hotTimes + i);
+        __m256 results = _mm256_cmp_ps(curTimeVec, tableDelaysVec, _CMP_GE_OQ);
+        
+        int mask = _mm256_movemask_ps(results);
+        // the lanes past a due list that can't grow are left for the next update
+        if(mask != 0 && !CallaterDueReserve(dueCount + 8))
+        {
+            hotCount = i;
+            break;
+        }
+        while (mask != 0)
+        {
+            unsigned long bit;
+#ifdef _WIN32
+            _BitScanForward(&bit, mask);
+#else
+            bit = __builtin_ctz(mask);
+#endif
+            mask &= ~(1 << bit);
+            table.dueSlots[dueCount++] = i + bit;
+        }
+    }
+    
+    const int remaining = CallaterDueReserve(dueCount + hotCount - i) ? hotCount - i : 0;
+    
+    for(int j = 0 ; j < remaining ; j++)
+    {
+        if(hotTimes[j + i] <= curTime)
+        {
+            table.dueSlots[dueCount++] = j + i;
+        }
+    }
+    
+    // take the due lanes out of the hot array before calling anything, so callbacks are free to
+    // insert and cancel. Going backwards means a swap-remove never moves a lane we still need
+    for(uint64_t j = dueCount ; j-- > firstDue ; )
+    {
+        uint64_t lane = table.dueSlots[j];
+        uint64_t idx = table.hot.slots[lane];
+        CallaterHotRemove(lane);
+        table.invokeData[idx].store = CALLATER_STORE_DUE;
+        table.dueSlots[j] = idx;
+    }
+    
+    return dueCount;
+}
+
+static float CallaterLinearMinInvokeTime()
+{
+    float newMinInvokeTime = INFINITY;
+    for(uint64_t i = 0 ; i < table.hot.count ; i++)
+    {
+        if(table.hot.invokeTimes[i] < newMinInvokeTime)
+        {
+            newMinInvokeTime = table.hot.invokeTimes[i];
+        }
+    }
+    if(table.far.count != 0 && table.far.invokes[0].invokeTime < newMinInvokeTime)
+    {
+        newMinInvokeTime = table.far.invokes[0].invokeTime;
+    }
+    return newMinInvokeTime;
+}
+
+// with the heap engine the hot array is empty and everything sits in the far store
+static void CallaterLinearMigrateIn()
+{
+    CallaterLinearAdvance(table.lastUpdated);
+}
+
+static bool CallaterHeapSchedule(uint64_t idx, float invokeTime)
+{
+    if(!CallaterFarReserve(&table.far, 1))
+        return false;
+    CallaterFarPush(idx, invokeTime);
+    return true;
+}
+
+static void CallaterHeapAdvance(float curTime)
+{
+    (void)curTime;
+}
+
+static uint64_t CallaterHeapCollectDue(float curTime, uint64_t dueCount)
+{
+    while(table.far.count != 0 && table.far.invokes[0].invokeTime <= curTime && CallaterDueReserve(dueCount + 1))
+    {
+        uint64_t idx = table.far.invokes[0].slot;
+        CallaterFarRemove(&table.far, 0);
+        table.invokeData[idx].store = CALLATER_STORE_DUE;
+        table.dueSlots[dueCount++] = idx;
+    }
+    return dueCount;
+}
+
+static float CallaterHeapMinInvokeTime()
+{
+    return table.far.count != 0 ? table.far.invokes[0].invokeTime : INFINITY;
+}
+
+static void CallaterHeapMigrateIn()
+{
+    while(table.hot.count != 0)
+    {
+        uint64_t lane = table.hot.count - 1;
+        uint64_t idx = table.hot.slots[lane];
+        float invokeTime = table.hot.invokeTimes[lane];
+        CallaterHotRemove(lane);
+        CallaterFarPush(idx, invokeTime);
+    }
+}
+
+static const CallaterBackend callaterLinearBackend = {
+    .engine        = CALLATER_ENGINE_LINEAR,
+    .schedule      = CallaterLinearSchedule,
+    .advance       = CallaterLinearAdvance,
+    .collectDue    = CallaterLinearCollectDue,
+    .minInvokeTime = CallaterLinearMinInvokeTime,
+    .migrateIn     = CallaterLinearMigrateIn,
+};
+
+static const CallaterBackend callaterHeapBackend = {
+    .engine        = CALLATER_ENGINE_HEAP,
+    .schedule      = CallaterHeapSchedule,
+    .advance       = CallaterHeapAdvance,
+    .collectDue    = CallaterHeapCollectDue,
+    .minInvokeTime = CallaterHeapMinInvokeTime,
+    .migrateIn     = CallaterHeapMigrateIn,
+};
+
+static void CallaterUseBackend(const CallaterBackend *backend)
+{
+    if(table.backend == backend)
+        return;
+    // the heap takes every lane of the hot array, the table stays linear if the far store can't grow that much
+    if(backend == &callaterHeapBackend && !CallaterFarReserve(&table.far, table.hot.count))
+        return;
+    
+    table.backend = backend;
+    backend->migrateIn();
+    CallaterFindNewMinInvokeTime();
+}
+
+// the linear engine wins when a good part of the table is due every update or when slots churn a lot
+// (lots of holes), since its inserts and removals are O(1). The heap wins with lots of sparse timers.
+// The thresholds for going back are looser so the table doesn't keep migrating back and forth
+static void CallaterAdaptEngine(uint64_t dueCount)
+{
+    CallaterAdaptiveStats *stats = &table.adaptive;
+    const uint64_t liveCount = table.count - table.noopCount;
+    const float dueRatio = liveCount == 0 ? 1.0f : (float)dueCount / liveCount;
+    stats->dueRatio += (dueRatio - stats->dueRatio) * (1.0f / CALLATER_ADAPTIVE_PERIOD);
+    
+    stats->updates += 1;
+    if(stats->updates < CALLATER_ADAPTIVE_PERIOD)
+        return;
+    stats->updates = 0;
+    
+    const float holeRatio = table.count == 0 ? 0.0f : (float)table.noopCount / table.count;
+    if(table.backend == &callaterLinearBackend)
+    {
+        if(liveCount >= CALLATER_ADAPTIVE_HEAP_COUNT && stats->dueRatio < 1.0f / 64 && holeRatio < 0.5f)
+        {
+            CallaterUseBackend(&callaterHeapBackend);
+        }
+    }
+    else
+    {
+        if(liveCount < CALLATER_ADAPTIVE_HEAP_COUNT / 2 || stats->dueRatio > 1.0f / 16 || holeRatio > 0.75f)
+        {
+            CallaterUseBackend(&callaterLinearBackend);
+        }
+    }
+}
+
+// moves every child clock by its parent's step times its scale, parents always come first
+// returns whether any of them has a due invocation
+static bool CallaterAdvanceClocks(float dt)
+{
+    bool due = false;
+    table.clocks[0].dt = dt;
+    for(uint64_t c = 1 ; c < table.clockCount ; c++)
+    {
+        CallaterClockState *clock = &table.clocks[c];
+        if(!clock->alive)
+            continue;
+        clock->dt = clock->paused ? 0 : table.clocks[clock->parent].dt * clock->scale;
+        clock->time += clock->dt;
+        due |= clock->heap.count != 0 && clock->heap.invokes[0].invokeTime <= clock->time && !CallaterClockHalted(c);
+    }
+    return due;
+}
+
+// how late a due invocation is, in real seconds as of `table.lastUpdated`
+// the time of a child clock is converted by its rate, or left as is while the clock is paused
+static float CallaterLateness(uint64_t idx)
+{
+    const uint64_t clock = table.invokeData[idx].clock;
+    if(clock == 0)
+        return table.lastUpdated - CallaterDueTime(idx);
+    const float rate = CallaterClockRate(clock);
+    const float late = table.clocks[clock].time - CallaterDueTime(idx);
+    return rate == 0 ? late : late / rate;
+}
+
+// higher priority lanes first, then latest first, whatever clock they're on
+static int CallaterCompareDue(const void *a, const void *b)
+{
+    const CallaterIndex idxA = *(const CallaterIndex*)a;
+    const CallaterIndex idxB = *(const CallaterIndex*)b;
+    const uint8_t laneA = table.invokeData[idxA].priority;
+    const uint8_t laneB = table.invokeData[idxB].priority;
+    if(laneA != laneB)
+        return (laneA > laneB) - (laneA < laneB);
+    const float lateA = CallaterLateness(idxA);
+    const float lateB = CallaterLateness(idxB);
+    return (lateA < lateB) - (lateA > lateB);
+}
+
+// calls at most `maxCalls` of the due invocations (and at most the budget of each lane) and stops once the fine clock reaches `deadline`
+// with a budget they're called by lane and earliest first, the ones left over go back to their stores still due, so the next
+// update calls them before anything newer. Their count is written to `backlog`
+static uint64_t CallaterTick(float curTime, uint64_t maxCalls, float deadline, uint64_t *backlog)
+{
+    uint64_t dueCount = table.backend->collectDue(curTime, 0);
+    
+#ifndef CALLATER_NO_REPEAT
+    // cohorts are sorted, so their due invocations are all at the front
+    for(uint64_t c = 0 ; c < CALLATER_MAX_COHORTS ; c++)
+    {
+        CallaterCohort *cohort = &table.cohorts[c];
+        while(cohort->count != 0 && CallaterDueTime(cohort->first) <= curTime && CallaterDueReserve(dueCount + 1))
+        {
+            uint64_t idx = cohort->first;
+            CallaterCohortRemove(idx);
+            table.invokeData[idx].store = CALLATER_STORE_DUE;
+            table.dueSlots[dueCount++] = idx;
+        }
+    }
+#endif
+    
+    for(uint64_t c = 1 ; c < table.clockCount ; c++)
+    {
+        CallaterFarStore *heap = &table.clocks[c].heap;
+        // what was added already due while the clock was paused waits for it to resume
+        if(CallaterClockHalted(c))
+            continue;
+        while(heap->count != 0 && heap->invokes[0].invokeTime <= table.clocks[c].time && CallaterDueReserve(dueCount + 1))
+        {
+            uint64_t idx = heap->invokes[0].slot;
+            CallaterFarRemove(heap, 0);
+            table.invokeData[idx].store = CALLATER_STORE_DUE;
+            table.dueSlots[dueCount++] = idx;
+        }
+    }
+    
+    if(maxCalls < dueCount || deadline != INFINITY || table.laneBudgeted || table.fixedStep)
+    {
+        qsort(table.dueSlots, dueCount, sizeof(*table.dueSlots), CallaterCompareDue);
+    }
+    
+    uint64_t laneCalls[CALLATER_PRIORITY_LANES] = {0};
+    uint64_t calls = 0;
+    bool outOfTime = false;
+    *backlog = 0;
+    for(uint64_t j = 0 ; j < dueCount ; j++)
+    {
+        uint64_t idx = table.dueSlots[j];
+        if(table.invokeData[idx].store != CALLATER_STORE_DUE)
+            continue;
+        
+        const uint8_t lane = table.invokeData[idx].priority;
+        outOfTime = outOfTime || (deadline != INFINITY && CallaterFineTime() >= deadline);
+        if(calls < maxCalls && laneCalls[lane] < table.laneBudgets[lane] && !outOfTime)
+        {
+            CallaterCallFunc(idx, curTime);
+            calls += 1;
+            laneCalls[lane] += 1;
+        }
+        else
+        {
+            table.invokeData[idx].store = CALLATER_STORE_NONE;
+            CallaterSchedule(idx, table.invokeTimes[idx]);
+            *backlog += 1;
+        }
+    }
+    
+    CallaterFindNewMinInvokeTime();
+    
+    if(table.count != 0 && table.funcs[table.count - 1] == CallaterNoop)
+    {
+        CallaterFindNewLastInvocation(table.count - 1);
+    }
+    
+    return dueCount;
+}
+
+// the time `CallaterUpdate` goes by, the fine clock only while precise invocations are pending
+static float CallaterUpdateTime()
+{
+    return table.preciseCount != 0 ? CallaterFineTime() : CallaterCurrentTime();
+}
+
+// makes room for one more entry, returns false if the ring is full and can't grow
+static bool CallaterRingReserve(CallaterDeferQueue *queue)
+{
+    if(queue->tail - queue->head < queue->cap)
+        return true;
+    
+    // the entries move to the positions they have with the new mask
+    const uint64_t newCap = queue->cap == 0 ? 64 : queue->cap * 2;
+    CallaterIndex *slots = CallaterResize(NULL, 0, newCap * sizeof(*slots), _Alignof(CallaterIndex));
+    if(slots == NULL)
+        return false;
+    for(uint64_t pos = queue->head ; pos != queue->tail ; pos++)
+    {
+        slots[pos & (newCap - 1)] = queue->slots[pos & (queue->cap - 1)];
+    }
+    CALLATER_RESIZE_ARRAY(queue->slots, queue->cap, 0, _Alignof(CallaterIndex));
+    queue->slots = slots;
+    queue->cap = newCap;
+    return true;
+}
+
+static bool CallaterRingPush(CallaterDeferQueue *queue, uint64_t idx)
+{
+    if(!CallaterRingReserve(queue))
+        return false;
+    queue->slots[queue->tail & (queue->cap - 1)] = idx;
+    queue->tail += 1;
+    return true;
+}
+
+// the caller made room with `CallaterRingReserve`
+static void CallaterDeferPush(CallaterDeferQueue *queue, uint64_t idx)
+{
+    table.invokeData[idx].store = queue->store;
+    table.invokeData[idx].storeIndex = queue->tail;
+    CallaterRingPush(queue, idx);
+}
+
+static uint64_t CallaterFrameTarget(uint64_t frames)
+{
+    return table.frame + (frames == 0 ? 1 : frames);
+}
+
+// makes room for an invocation due `frames` updates from now, returns false if there's no memory for it
+static bool CallaterFrameReserve(uint64_t frames)
+{
+    if(table.frameWheel == NULL)
+    {
+        CallaterDeferQueue *wheel = CallaterResize(NULL, 0, CALLATER_FRAME_BUCKETS * sizeof(*wheel), _Alignof(CallaterDeferQueue));
+        if(wheel == NULL)
+            return false;
+        memset(wheel, 0, CALLATER_FRAME_BUCKETS * sizeof(*wheel));
+        table.frameWheel = wheel;
+    }
+    return CallaterRingReserve(&table.frameWheel[CallaterFrameTarget(frames) & (CALLATER_FRAME_BUCKETS - 1)]);
+}
+
+// makes the invocation due on the `frames`th update from now, at least the next one
+// returns false and leaves the slot as it was if there's no memory for it
+static bool CallaterFramePush(uint64_t idx, uint64_t frames)
+{
+    if(!CallaterFrameReserve(frames))
+        return false;
+    
+    const uint64_t target = CallaterFrameTarget(frames);
+    table.invokeData[idx].store = CALLATER_STORE_FRAME;
+    table.invokeData[idx].storeIndex = target;
+    CallaterRingPush(&table.frameWheel[target & (CALLATER_FRAME_BUCKETS - 1)], idx);
+    table.frameCount += 1;
+    return true;
+}
+
+static void CallaterCallFrameFunc(uint64_t idx)
+{
+    table.invokeData[idx].store = CALLATER_STORE_DUE;
+    table.frameCount -= 1;
+    table.funcs[idx](CALLATER_ARG_UNPACK(table.args[idx]), (CallaterRef){idx});
+    
+    // the callback cancelled, paused or rescheduled its own invocation
+    if(table.invokeData[idx].store != CALLATER_STORE_DUE)
+        return;
+    
+#ifndef CALLATER_NO_REPEAT
+    // with no memory left for the next call it's dropped
+    const float repeatRate = table.invokeData[idx].repeatRate;
+    if(!signbit(repeatRate) && CallaterFramePush(idx, (uint64_t)repeatRate))
+    {
+        return;
+    }
+#endif
+    CallaterPopInvoke(idx);
+}
+
+// pops the bucket of `table.frame`. Entries of slots that were cancelled or moved since are dropped,
+// those due a round later go back in the bucket
+static void CallaterDrainFrame()
+{
+    const uint64_t bucketIndex = table.frame & (CALLATER_FRAME_BUCKETS - 1);
+    CallaterDeferQueue *bucket = &table.frameWheel[bucketIndex];
+    const uint64_t end = bucket->tail;
+    while(bucket->head != end)
+    {
+        const uint64_t idx = bucket->slots[bucket->head & (bucket->cap - 1)];
+        bucket->head += 1;
+        if(table.invokeData[idx].store != CALLATER_STORE_FRAME)
+            continue;
+        
+        const CallaterIndex target = table.invokeData[idx].storeIndex;
+        if(target == (CallaterIndex)table.frame)
+        {
+            CallaterCallFrameFunc(idx);
+        }
+        else if((target & (CALLATER_FRAME_BUCKETS - 1)) == bucketIndex && !CallaterRingPush(bucket, idx))
+        {
+            // callbacks filled the bucket again and it can't grow
+            CallaterPopInvoke(idx);
+        }
+    }
+    
+    if(table.count != 0 && table.funcs[table.count - 1] == CallaterNoop)
+    {
+        CallaterFindNewLastInvocation(table.count - 1);
+    }
+}
+
+// calls what was in `queue` when the drain started, invocations deferred by the callbacks wait for the next drain
+static void CallaterDrainDeferred(CallaterDeferQueue *queue, float curTime)
+{
+    const uint64_t end = queue->tail;
+    while(queue->head != end)
+    {
+        const uint64_t pos = queue->head;
+        const uint64_t idx = queue->slots[pos & (queue->cap - 1)];
+        queue->head += 1;
+        if(table.invokeData[idx].store == queue->store && table.invokeData[idx].storeIndex == (CallaterIndex)pos)
+        {
+            table.invokeData[idx].store = CALLATER_STORE_DUE;
+            CallaterCallFunc(idx, curTime);
+        }
+    }
+    
+    if(table.count != 0 && table.funcs[table.count - 1] == CallaterNoop)
+    {
+        CallaterFindNewLastInvocation(table.count - 1);
+    }
+}
+
+// what every update does before its timed invocations
+static void CallaterBeginUpdate(float curTime)
+{
+    if(table.deferNext.head != table.deferNext.tail)
+    {
+        CallaterDrainDeferred(&table.deferNext, curTime);
+    }
+    
+    table.frame += 1;
+    if(table.frameWheel != NULL)
+    {
+        CallaterDrainFrame();
+    }
+}
+
+// and after them
+static void CallaterEndUpdate(float curTime, uint64_t dueCount)
+{
+    if(table.deferEndOfUpdate.head != table.deferEndOfUpdate.tail)
+    {
+        CallaterDrainDeferred(&table.deferEndOfUpdate, curTime);
+    }
+    
+    if(table.engine == CALLATER_ENGINE_ADAPTIVE)
+    {
+        CallaterAdaptEngine(dueCount);
+    }
+}
+
+static uint64_t CallaterUpdateWithin(uint64_t maxCalls, float maxSeconds)
+{
+    float curTime = CallaterUpdateTime();
+    bool clockDue = CallaterAdvanceClocks(curTime - table.lastUpdated);
+    table.lastUpdated = curTime;
+    
+    table.backend->advance(curTime);
+    
+    CallaterBeginUpdate(curTime);
+    
+    uint64_t dueCount = 0;
+    uint64_t backlog = 0;
+    
+    // do we even need the second term? minInvokeTime should be enough
+    if((curTime >= table.minInvokeTime || clockDue) && table.count != 0)
+    {
+        const float deadline = maxSeconds == INFINITY ? INFINITY : CallaterFineTime() + maxSeconds;
+        dueCount = CallaterTick(curTime, maxCalls, deadline, &backlog);
+    }
+    
+    CallaterEndUpdate(curTime, dueCount);
+    return backlog;
+}
+
+void CallaterUpdate()
+{
+    CallaterUpdateWithin((uint64_t)-1, INFINITY);
+}
+
+uint64_t CallaterUpdateBudget(uint64_t maxCalls, float maxSeconds)
+{
+    return CallaterUpdateWithin(maxCalls, maxSeconds);
+}
+
+uint64_t CallaterUpdateFixed(float dt, uint64_t maxSubsteps)
+{
+    const float curTime = CallaterUpdateTime();
+    const uint64_t pending = dt > 0 && curTime > table.lastUpdated ? (uint64_t)((curTime - table.lastUpdated) / dt) : 0;
+    const uint64_t steps = szmin(pending, maxSubsteps);
+    
+    // deferred and frame calls at the start see the time the substeps start from too
+    table.fixedStep = true;
+    CallaterBeginUpdate(table.lastUpdated);
+    
+    uint64_t dueCount = 0;
+    uint64_t backlog;
+    const float start = table.lastUpdated;
+    for(uint64_t s = 1 ; s <= steps ; s++)
+    {
+        // the steps past `maxSubsteps` stay pending, `table.lastUpdated` only moves by the steps run
+        const float stepTime = start + s * dt;
+        const bool clockDue = CallaterAdvanceClocks(stepTime - table.lastUpdated);
+        table.lastUpdated = stepTime;
+        table.backend->advance(stepTime);
+        
+        // substeps with nothing due don't scan
+        if((stepTime >= table.minInvokeTime || clockDue) && table.count != 0)
+        {
+            dueCount += CallaterTick(stepTime, (uint64_t)-1, INFINITY, &backlog);
+        }
+    }
+    table.fixedStep = false;
+    
+    CallaterEndUpdate(table.lastUpdated, dueCount);
+    return steps;
+}
+
+// the exponent of the biggest power of two that's at most `seconds`
+static int8_t CallaterSlackExp(float seconds)
+{
+    if(!(seconds > 0))
+        return CALLATER_NO_SLACK;
+    int exp;
+    frexpf(seconds, &exp);
+    exp -= 1;
+    return exp < -60 ? -60 : exp > 60 ? 60 : exp;
+}
+
+void CallaterSetSlack(CallaterRef ref, float seconds)
+{
+    const uint64_t idx = ref.ref;
+    table.invokeData[idx].slackExp = CallaterSlackExp(seconds);
+    switch(table.invokeData[idx].store)
+    {
+        case CALLATER_STORE_HOT:
+        case CALLATER_STORE_FAR:
+#ifndef CALLATER_NO_REPEAT
+        case CALLATER_STORE_COHORT:
+#endif
+        case CALLATER_STORE_CLOCK:
+        {
+            // a smaller slack can only move it earlier, which `CallaterSchedule` covers
+            const float invokeTime = table.invokeTimes[idx];
+            CallaterUnschedule(idx);
+            CallaterSchedule(idx, invokeTime);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+float CallaterGetSlack(CallaterRef ref)
+{
+    const int8_t slackExp = table.invokeData[ref.ref].slackExp;
+    return slackExp == CALLATER_NO_SLACK ? 0 : ldexpf(1, slackExp);
+}
+
+void CallaterSetDefaultSlack(float seconds)
+{
+    table.defaultSlackExp = CallaterSlackExp(seconds);
+}
+
+void CallaterSetPriority(CallaterRef ref, uint8_t lane)
+{
+    table.invokeData[ref.ref].priority = lane < CALLATER_PRIORITY_LANES ? lane : CALLATER_PRIORITY_LANES - 1;
+}
+
+uint8_t CallaterGetPriority(CallaterRef ref)
+{
+    return table.invokeData[ref.ref].priority;
+}
+
+void CallaterSetLaneBudget(uint8_t lane, uint64_t maxCalls)
+{
+    if(lane >= CALLATER_PRIORITY_LANES)
+        return;
+    table.laneBudgets[lane] = maxCalls;
+    table.laneBudgeted = false;
+    for(uint64_t i = 0 ; i < CALLATER_PRIORITY_LANES ; i++)
+    {
+        table.laneBudgeted |= table.laneBudgets[i] != (uint64_t)-1;
+    }
+}
+
+void CallaterSetPrecise(CallaterRef ref, bool precise)
+{
+    CallaterInvokeData *data = &table.invokeData[ref.ref];
+    table.preciseCount += (uint64_t)precise - data->precise;
+    data->precise = precise;
+}
+
+bool CallaterGetPrecise(CallaterRef ref)
+{
+    return table.invokeData[ref.ref].precise;
+}
+
+// real time of the next due invocation, can be early since `table.minInvokeTime` is only a lower bound
+static float CallaterNextDueTime()
+{
+    // deferred calls and frame invocations run at the next update, whenever that is
+    if(table.deferNext.head != table.deferNext.tail || table.frameCount != 0)
+        return table.lastUpdated;
+    
+    float next = table.minInvokeTime;
+    for(uint64_t c = 1 ; c < table.clockCount ; c++)
+    {
+        const CallaterClockState *clock = &table.clocks[c];
+        const float rate = CallaterClockRate(c);
+        if(clock->heap.count != 0 && rate != 0)
+        {
+            next = fminf(next, table.lastUpdated + (clock->heap.invokes[0].invokeTime - clock->time) / rate);
+        }
+    }
+    return next;
+}
+
+static void CallaterSleep(float seconds)
+{
+#ifdef _WIN32
+    Sleep((DWORD)(seconds * 1000));
+#else
+    struct timespec ts = {.tv_sec = (time_t)seconds, .tv_nsec = (long)((seconds - (time_t)seconds) * 1e9f)};
+    nanosleep(&ts, NULL);
+#endif
+}
+
+void CallaterWait(float maxSeconds)
+{
+    const float curTime = CallaterUpdateTime();
+    const float target = fminf(CallaterNextDueTime(), curTime + maxSeconds);
+    if(target <= curTime || target == INFINITY)
+        return;
+    
+    // a time source of the user may only move between frames, spinning on it could never end
+    if(table.preciseCount == 0 || table.timeSource != NULL)
+    {
+        CallaterSleep(target - curTime);
+        return;
+    }
+    
+    // sleeping overshoots, so wake up a bit early and spin the rest of the way on the fine clock
+    if(target - curTime > CALLATER_SPIN_MARGIN)
+    {
+        CallaterSleep(target - curTime - CALLATER_SPIN_MARGIN);
+    }
+    while(CallaterFineTime() < target)
+    {
+        _mm_pause();
+    }
+}
+
+void CallaterSetHorizon(float seconds)
+{
+    table.horizon = seconds;
+}
+
+float CallaterGetHorizon()
+{
+    return table.horizon;
+}
+
+void CallaterSetEngine(CallaterEngine engine)
+{
+    table.engine = engine;
+    table.adaptive = (CallaterAdaptiveStats){0};
+    if(engine == CALLATER_ENGINE_LINEAR)
+    {
+        CallaterUseBackend(&callaterLinearBackend);
+    }
+    else if(engine == CALLATER_ENGINE_HEAP)
+    {
+        CallaterUseBackend(&callaterHeapBackend);
+    }
+}
+
+CallaterEngine CallaterGetEngine()
+{
+    return table.backend->engine;
+}
+
+void CallaterSetTimeSource(float(*now)(void *user), void *user)
+{
+    table.timeSource = now;
+    table.timeSourceUser = user;
+    // so the first update on the new timeline doesn't see a jump
+    table.lastUpdated = CallaterCurrentTime();
+}
+
+void CallaterSetFrameTime(bool enabled)
+{
+    table.frameTime = enabled;
+}
+
+bool CallaterGetFrameTime()
+{
+    return table.frameTime;
+}
+
+// assigning a new table.nextEmptySpot
+static void CallaterAssignNextEmptySpot()
+{
+    if(table.noopCount == 0)
+    {
+        if(table.count >= table.cap)
+        {
+            table.nextEmptySpot = (uint64_t)-1;
+        }
+        else
+        {
+            table.nextEmptySpot = table.count;
+        }
+    }
+    else
+    {
+        if(table.count < table.cap)
+        {
+            table.nextEmptySpot = table.count;
+        }
+        else
+        {
+            uint64_t nextEmptySpot = (uint64_t)-1;
+            for(uint64_t i = 0 ; i < table.count ; i++)
+            {
+                if(table.funcs[i] == CallaterNoop)
+                {
+                    nextEmptySpot = i;
+                    break;
+                }
+            }
+            table.nextEmptySpot = nextEmptySpot;
+        }
+    }
+}
+
+CallaterRef CallaterInvoke(void(*func)(void*, CallaterRef), void* arg, float delay)
+{
+    return CallaterInvokeGID(func, arg, delay, CALLATER_NO_GROUP);
+}
+
+// makes room for `n` more invocations on `clock` in every store they could end up in, so scheduling them can't fail
+static bool CallaterReserveStores(uint64_t clock, uint64_t n)
+{
+    if(clock != 0)
+        return CallaterFarReserve(&table.clocks[clock].heap, n);
+    return CallaterFarReserve(&table.far, n) && (table.backend != &callaterLinearBackend || CallaterHotReserve(n));
+}
+
+// takes the next empty slot, growing the table if needed. Returns `CALLATER_NO_SLOT` if it's full or can't grow
+// the caller fills the slot then calls `CallaterAssignNextEmptySpot`
+static uint64_t CallaterTakeSlot()
+{
+    if(table.nextEmptySpot == (uint64_t)-1)
+    {
+        if(!CallaterMaybeGrowTable())
+            return CALLATER_NO_SLOT;
+        table.nextEmptySpot = table.count;
+        table.count += 1;
+    }
+    else if(table.nextEmptySpot < table.count)
+    {
+        // next empty spot is in the middle of the array
+        // aka we're taking the spot of a noop and not increasing count
+        table.noopCount -= 1;
+    }
+    else
+    {
+        // next empty spot is at the back
+        table.nextEmptySpot = table.count;
+        table.count += 1;
+    }
+    return table.nextEmptySpot;
+}
+
+// `clock` must be alive and `curTime` in its time
+static CallaterRef CallaterInvokeOnClock(void(*func)(void*, CallaterRef), void *arg, float delay, CallaterGroupId groupId, uint64_t clock, float curTime)
+{
+    if(!CallaterReserveStores(clock, 1))
+        return CALLATER_REF_ERR;
+    
+    uint64_t nextSpot = CallaterTakeSlot();
+    if(nextSpot == CALLATER_NO_SLOT)
+        return CALLATER_REF_ERR;
+    
+    table.funcs      [nextSpot] = func;
+    table.args       [nextSpot] = CALLATER_ARG_PACK(arg);
+    CALLATER_SET_REPEAT(table.invokeData[nextSpot], -fabsf(delay));
+    CALLATER_SET_POLICY(table.invokeData[nextSpot], CALLATER_REPEAT_DELAY);
+    CALLATER_SET_GROUP (table.invokeData[nextSpot], groupId);
+    CallaterResetExtras(&table.invokeData[nextSpot]);
+    table.invokeData[nextSpot].clock = clock;
+    CallaterSchedule(nextSpot, delay + curTime);
+    
+    CallaterAssignNextEmptySpot();
+    return (CallaterRef){nextSpot};
+}
+
+CallaterRef CallaterInvokeGID(void(*func)(void*, CallaterRef), void *arg, float delay, CallaterGroupId groupId)
+{
+    return CallaterInvokeOnClock(func, arg, delay, groupId, 0, CallaterNow());
+}
+
+// takes a slot for an invocation that isn't timed, the caller puts it in its queue then calls `CallaterAssignNextEmptySpot`
+static uint64_t CallaterTakeUntimedSlot(void(*func)(void*, CallaterRef), void *arg, float repeatRate)
+{
+    uint64_t idx = CallaterTakeSlot();
+    if(idx == CALLATER_NO_SLOT)
+        return CALLATER_NO_SLOT;
+    
+    table.funcs[idx] = func;
+    table.args [idx] = CALLATER_ARG_PACK(arg);
+    CALLATER_SET_REPEAT(table.invokeData[idx], repeatRate);
+    CALLATER_SET_POLICY(table.invokeData[idx], CALLATER_REPEAT_DELAY);
+    CALLATER_SET_GROUP (table.invokeData[idx], CALLATER_NO_GROUP);
+    CallaterResetExtras(&table.invokeData[idx]);
+    // no clock read, it's due as of the last update
+    table.invokeTimes[idx] = table.lastUpdated;
+    return idx;
+}
+
+static CallaterRef CallaterDeferTo(CallaterDeferQueue *queue, void(*func)(void*, CallaterRef), void *arg)
+{
+    // the queues grow on their own, a fixed table runs it as a due invocation instead
+    if(table.fixed)
+        return CallaterInvokeOnClock(func, arg, 0, CALLATER_NO_GROUP, 0, table.lastUpdated);
+    
+    if(!CallaterRingReserve(queue))
+        return CALLATER_REF_ERR;
+    uint64_t idx = CallaterTakeUntimedSlot(func, arg, -0.0f);
+    if(idx == CALLATER_NO_SLOT)
+        return CALLATER_REF_ERR;
+    
+    CallaterDeferPush(queue, idx);
+    CallaterAssignNextEmptySpot();
+    return (CallaterRef){idx};
+}
+
+CallaterRef CallaterDefer(void(*func)(void*, CallaterRef), void *arg)
+{
+    return CallaterDeferTo(&table.deferNext, func, arg);
+}
+
+CallaterRef CallaterDeferEndOfUpdate(void(*func)(void*, CallaterRef), void *arg)
+{
+    return CallaterDeferTo(&table.deferEndOfUpdate, func, arg);
+}
+
+static CallaterRef CallaterInvokeFrames(void(*func)(void*, CallaterRef), void *arg, uint64_t frames, float repeatRate)
+{
+    // the buckets grow on their own
+    if(table.fixed || !CallaterFrameReserve(frames))
+        return CALLATER_REF_ERR;
+    
+    uint64_t idx = CallaterTakeUntimedSlot(func, arg, repeatRate);
+    if(idx == CALLATER_NO_SLOT)
+        return CALLATER_REF_ERR;
+    
+    table.invokeData[idx].frames = true;
+    CallaterFramePush(idx, frames);
+    CallaterAssignNextEmptySpot();
+    return (CallaterRef){idx};
+}
+
+CallaterRef CallaterInvokeAfterFrames(void(*func)(void*, CallaterRef), void *arg, uint64_t frames)
+{
+    return CallaterInvokeFrames(func, arg, frames, -0.0f);
+}
+
+#ifndef CALLATER_NO_REPEAT
+CallaterRef CallaterInvokeEveryNFrames(void(*func)(void*, CallaterRef), void *arg, uint64_t n)
+{
+    n = n == 0 ? 1 : n;
+    return CallaterInvokeFrames(func, arg, n, (float)n);
+}
+#endif
+
+uint64_t CallaterGetFrame()
+{
+    return table.frame;
+}
+
+CallaterRef CallaterInvokePrecise(void(*func)(void*, CallaterRef), void *arg, float delay)
+{
+    // the default slack would round the invoke time it's so careful about
+    const int8_t defaultSlackExp = table.defaultSlackExp;
+    table.defaultSlackExp = CALLATER_NO_SLACK;
+    CallaterRef ret = CallaterInvokeOnClock(func, arg, delay, CALLATER_NO_GROUP, 0, CallaterFineTime());
+    table.defaultSlackExp = defaultSlackExp;
+    if(!CallaterRefError(ret))
+        CallaterSetPrecise(ret, true);
+    return ret;
+}
+
+CallaterRef CallaterInvokeClock(void(*func)(void*, CallaterRef), void *arg, float delay, CallaterClock clock)
+{
+    if(!CallaterClockValid(clock))
+        return CALLATER_REF_ERR;
+    return CallaterInvokeOnClock(func, arg, delay, CALLATER_NO_GROUP, clock.id, table.clocks[clock.id].time);
+}
+
+#ifndef CALLATER_NO_REPEAT
+
+CallaterRef CallaterInvokeRepeat(void(*func)(void*, CallaterRef), void *arg, float firstDelay, float repeatRate)
+{
+    return CallaterInvokeRepeatGID(func, arg, firstDelay, repeatRate, CALLATER_NO_GROUP);
+}
+
+// a fraction of the period picked from the slot: golden ratio steps, so consecutive slots spread evenly over [0, 1)
+static float CallaterStaggerPhase(uint64_t idx)
+{
+    return (uint32_t)(idx * 2654435769u) * (1.0f / 4294967296.0f);
+}
+
+// delays the first call of a repeating invocation by its phase within the period
+static void CallaterStaggerSlot(uint64_t idx)
+{
+    const float repeatRate = table.invokeData[idx].repeatRate;
+    if(signbit(repeatRate))
+        return;
+    const float invokeTime = table.invokeTimes[idx];
+    CallaterUnschedule(idx);
+    CallaterSchedule(idx, invokeTime + CallaterStaggerPhase(idx) * repeatRate);
+}
+
+// same as `CallaterStaggerSlot` for slots whose times are written but not scheduled yet
+static void CallaterStaggerAppended(uint64_t first, uint64_t n)
+{
+    for(uint64_t i = first ; i < first + n ; i++)
+    {
+        const float repeatRate = table.invokeData[i].repeatRate;
+        if(!signbit(repeatRate))
+        {
+            table.invokeTimes[i] += CallaterStaggerPhase(i) * repeatRate;
+        }
+    }
+}
+
+CallaterRef CallaterInvokeRepeatGID(void(*func)(void*, CallaterRef), void *arg, float firstDelay, float repeatRate, CallaterGroupId groupId)
+{
+    CallaterRef ret = CallaterInvokeGID(func, arg, firstDelay, groupId);
+    if(CallaterRefError(ret))
+        return ret;
+    CallaterSetRepeatRate(ret, repeatRate);
+    if(table.staggerRepeats)
+        CallaterStaggerSlot(ret.ref);
+    return ret;
+}
+
+CallaterRef CallaterInvokeRepeatStaggered(void(*func)(void*, CallaterRef), void *arg, float firstDelay, float repeatRate)
+{
+    CallaterRef ret = CallaterInvokeGID(func, arg, firstDelay, CALLATER_NO_GROUP);
+    if(CallaterRefError(ret))
+        return ret;
+    CallaterSetRepeatRate(ret, repeatRate);
+    CallaterStaggerSlot(ret.ref);
+    return ret;
+}
+
+void CallaterSetStaggerRepeats(bool enabled)
+{
+    table.staggerRepeats = enabled;
+}
+
+bool CallaterGetStaggerRepeats()
+{
+    return table.staggerRepeats;
+}
+
+CallaterRef CallaterInvokeRepeatClock(void(*func)(void*, CallaterRef), void *arg, float firstDelay, float repeatRate, CallaterClock clock)
+{
+    CallaterRef ret = CallaterInvokeClock(func, arg, firstDelay, clock);
+    if(CallaterRefError(ret))
+        return ret;
+    CallaterSetRepeatRate(ret, repeatRate);
+    if(table.staggerRepeats)
+        CallaterStaggerSlot(ret.ref);
+    return ret;
+}
+
+#endif
+
+// makes room for `n` invocations after `table.count` with at most one reallocation
+// Returns the first of the `n` slots, or -1 if the table can't hold that many or can't grow
+static uint64_t CallaterAppendSlots(uint64_t n)
+{
+    if(table.count + n > table.cap)
+    {
+        const uint64_t limit = CallaterCapLimit();
+        if(table.count + n > limit)
+            return (uint64_t)-1;
+        uint64_t newCap = table.cap == 0 ? 64 : table.cap;
+        while(newCap < table.count + n)
+        {
+            newCap *= 2;
+        }
+        if(!CallaterReallocTable(szmin(newCap, limit)))
+            return (uint64_t)-1;
+    }
+    
+    uint64_t first = table.count;
+    table.count += n;
+    return first;
+}
+
+// schedules the `n` invocations from slot `first` whose times were already written to `table.invokeTimes`
+// returns false, with none of them scheduled, if the stores can't grow enough to hold them
+static bool CallaterScheduleAppended(uint64_t first, uint64_t n)
+{
+    float minInvokeTime = table.minInvokeTime;
+    const bool linear = table.backend == &callaterLinearBackend;
+    const float hotUntil = table.lastUpdated + table.horizon;
+    
+    uint64_t hotCount = 0;
+    for(uint64_t i = first ; linear && i < first + n ; i++)
+    {
+        hotCount += CallaterDueTime(i) <= hotUntil;
+    }
+    if(!CallaterHotReserve(hotCount) || !CallaterFarReserve(&table.far, n - hotCount))
+        return false;
+    
+    for(uint64_t i = first ; i < first + n ; i++)
+    {
+        const float invokeTime = CallaterDueTime(i);
+        if(linear && invokeTime <= hotUntil)
+        {
+            CallaterHotInsert(i, invokeTime);
+        }
+        else
+        {
+            table.backend->schedule(i, invokeTime);
+        }
+        minInvokeTime = invokeTime < minInvokeTime ? invokeTime : minInvokeTime;
+    }
+    
+    table.minInvokeTime = minInvokeTime;
+    CallaterAssignNextEmptySpot();
+    return true;
+}
+
+// nothing was added, every ref is an error
+static void CallaterFailBatch(CallaterRef *refsOut, uint64_t n)
+{
+    if(refsOut == NULL)
+        return;
+    for(uint64_t i = 0 ; i < n ; i++)
+    {
+        refsOut[i] = CALLATER_REF_ERR;
+    }
+}
+
+// the `n` slots appended from `first` weren't scheduled, nothing else points to them yet
+static void CallaterDropAppended(uint64_t first, uint64_t n, CallaterRef *refsOut)
+{
+    table.count = first;
+    CallaterFailBatch(refsOut, n);
+}
+
+// `args` can be NULL for no args
+static void CallaterCopyArgs(CallaterArg *dst, void **args, uint64_t n)
+{
+#ifdef CALLATER_COMPACT_ARGS
+    for(uint64_t i = 0 ; i < n ; i++)
+    {
+        dst[i] = args != NULL ? CALLATER_ARG_PACK(args[i]) : 0;
+    }
+#else
+    if(args != NULL)
+        memcpy(dst, args, n * sizeof(*dst));
+    else
+        memset(dst, 0, n * sizeof(*dst));
+#endif
+}
+
+// table.invokeTimes[i] = delays[i] + curTime
+static void CallaterFillInvokeTimes(float *invokeTimes, const float *delays, uint64_t n, float curTime)
+{
+    const __m256 curTimeVec = _mm256_set1_ps(curTime);
+    
+    uint64_t i;
+    for(i = 0 ; i + 7 < n ; i += 8)
+    {
+        _mm256_storeu_ps(invokeTimes + i, _mm256_add_ps(_mm256_loadu_ps(delays + i), curTimeVec));
+    }
+    for( ; i < n ; i++)
+    {
+        invokeTimes[i] = delays[i] + curTime;
+    }
+}
+
+void CallaterInvokeBatch(void(**funcs)(void*, CallaterRef), void **args, const float *delays, const float *repeatRates, const CallaterGroupId *groupIds, uint64_t n, CallaterRef *refsOut)
+{
+    if(n == 0)
+        return;
+    
+    const float curTime = CallaterNow();
+    const uint64_t first = CallaterAppendSlots(n);
+    if(first == (uint64_t)-1)
+    {
+        CallaterFailBatch(refsOut, n);
+        return;
+    }
+    
+    memcpy(table.funcs + first, funcs, n * sizeof(*table.funcs));
+    CallaterCopyArgs(table.args + first, args, n);
+    CallaterFillInvokeTimes(table.invokeTimes + first, delays, n, curTime);
+    
+    for(uint64_t i = 0 ; i < n ; i++)
+    {
+        CALLATER_SET_REPEAT(table.invokeData[first + i], repeatRates != NULL ? repeatRates[i] : -fabsf(delays[i]));
+        CALLATER_SET_POLICY(table.invokeData[first + i], CALLATER_REPEAT_DELAY);
+        CALLATER_SET_GROUP (table.invokeData[first + i], groupIds    != NULL ? groupIds[i]    : CALLATER_NO_GROUP);
+        CallaterResetExtras(&table.invokeData[first + i]);
+    }
+    
+#ifndef CALLATER_NO_REPEAT
+    if(table.staggerRepeats && repeatRates != NULL)
+        CallaterStaggerAppended(first, n);
+#endif
+    if(!CallaterScheduleAppended(first, n))
+    {
+        CallaterDropAppended(first, n, refsOut);
+        return;
+    }
+    
+    if(refsOut != NULL)
+    {
+        for(uint64_t i = 0 ; i < n ; i++)
+        {
+            refsOut[i].ref = first + i;
+        }
+    }
+}
+
+void CallaterInvokeBatchArgs(void(*func)(void*, CallaterRef), void **args, float delay, float repeatRate, CallaterGroupId groupId, uint64_t n, CallaterRef *refsOut)
+{
+    if(n == 0)
+        return;
+    
+    const float invokeTime = delay + CallaterNow();
+    const uint64_t first = CallaterAppendSlots(n);
+    if(first == (uint64_t)-1)
     {
-        CallaterMaybeGrowTable();
-        table.nextEmptySpot = table.count;
-        table.count += 1;
+        CallaterFailBatch(refsOut, n);
+        return;
     }
-    else if(table.nextEmptySpot < table.count)
+    
+    CallaterCopyArgs(table.args + first, args, n);
+    
+    const __m256 invokeTimeVec = _mm256_set1_ps(invokeTime);
+    uint64_t i;
+    for(i = 0 ; i + 7 < n ; i += 8)
     {
-        // next empty spot is in the middle of the array
-        // aka we're taking the spot of a noop and not increasing count
-        table.noopCount -= 1;
+        _mm256_storeu_ps(table.invokeTimes + first + i, invokeTimeVec);
     }
-    else
+    for( ; i < n ; i++)
     {
-        // next empty spot is at the back
-        table.nextEmptySpot = table.count;
-        table.count += 1;
+        table.invokeTimes[first + i] = invokeTime;
     }
     
-    float curTime = CallaterCurrentTime();
+    CallaterInvokeData data = {0};
+    CALLATER_SET_GROUP(data, groupId);
+    CALLATER_SET_REPEAT(data, repeatRate);
+    CALLATER_SET_POLICY(data, CALLATER_REPEAT_DELAY);
+    CallaterResetExtras(&data);
+    for(i = first ; i < first + n ; i++)
+    {
+        table.funcs[i] = func;
+        table.invokeData[i] = data;
+    }
     
-    uint64_t nextSpot = table.nextEmptySpot;
-    table.funcs      [nextSpot] = func;
-    table.invokeTimes[nextSpot] = delay + curTime;
-    table.args       [nextSpot] = arg;
-    table.invokeData [nextSpot].repeatRate  = -delay;
-    table.invokeData [nextSpot].groupId     = groupId;
-    table.invokeData [nextSpot].pausedIndex = (uint64_t)-1;
-    if(table.invokeTimes[nextSpot] < table.minInvokeTime)
+#ifndef CALLATER_NO_REPEAT
+    if(table.staggerRepeats)
+        CallaterStaggerAppended(first, n);
+#endif
+    if(!CallaterScheduleAppended(first, n))
     {
-        table.minInvokeTime = table.invokeTimes[nextSpot];
+        CallaterDropAppended(first, n, refsOut);
+        return;
     }
     
-    // assigning a new table.nextEmptySpot
-    if(table.noopCount == 0)
+    if(refsOut != NULL)
     {
-        if(table.count >= table.cap)
-        {
-            table.nextEmptySpot = (uint64_t)-1;
-        }
-        else
+        for(i = 0 ; i < n ; i++)
         {
-            table.nextEmptySpot = table.count;
+            refsOut[i].ref = first + i;
         }
     }
-    else
+}
+
+#ifndef CALLATER_COMPACT_ARGS
+
+static void *CallaterPayloadOf(uint64_t idx)
+{
+    CallaterPayloadSlab *slab = &table.payloads;
+    uint64_t block = idx / CALLATER_PAYLOAD_BLOCK;
+    if(block >= slab->blockCount)
     {
-        if(table.count < table.cap)
-        {
-            table.nextEmptySpot = table.count;
-        }
-        else
-        {
-            uint64_t nextEmptySpot = (uint64_t)-1;
-            for(uint64_t i = 0 ; i < table.count ; i++)
-            {
-                if(table.funcs[i] == CallaterNoop)
-                {
-                    nextEmptySpot = i;
-                    break;
-                }
-            }
-            table.nextEmptySpot = nextEmptySpot;
-        }
+        if(!CALLATER_RESIZE_ARRAY(slab->blocks, slab->blockCount, block + 1, _Alignof(unsigned char*)))
+            return NULL;
+        memset(slab->blocks + slab->blockCount, 0, (block + 1 - slab->blockCount) * sizeof(*slab->blocks));
+        slab->blockCount = block + 1;
     }
-    return (CallaterRef){nextSpot};
+    if(slab->blocks[block] == NULL)
+    {
+        slab->blocks[block] = CallaterResize(NULL, 0, CALLATER_PAYLOAD_BLOCK * CALLATER_PAYLOAD_SIZE, _Alignof(max_align_t));
+        if(slab->blocks[block] == NULL)
+            return NULL;
+    }
+    return slab->blocks[block] + (idx % CALLATER_PAYLOAD_BLOCK) * CALLATER_PAYLOAD_SIZE;
 }
 
-CallaterRef CallaterInvokeRepeat(void(*func)(void*, CallaterRef), void *arg, float firstDelay, float repeatRate)
+CallaterRef CallaterInvokeCopy(void(*func)(void*, CallaterRef), const void *payload, uint64_t size, float delay)
 {
-    return CallaterInvokeRepeatGID(func, arg, firstDelay, repeatRate, (uint64_t)-1);
+    return CallaterInvokeCopyGID(func, payload, size, delay, CALLATER_NO_GROUP);
 }
 
-CallaterRef CallaterInvokeRepeatGID(void(*func)(void*, CallaterRef), void *arg, float firstDelay, float repeatRate, uint64_t groupId)
+CallaterRef CallaterInvokeCopyGID(void(*func)(void*, CallaterRef), const void *payload, uint64_t size, float delay, CallaterGroupId groupId)
 {
-    CallaterRef ret = CallaterInvokeGID(func, arg, firstDelay, groupId);
-    CallaterSetRepeatRate(ret, repeatRate);
+    if(size > CALLATER_PAYLOAD_SIZE)
+    {
+        return CALLATER_REF_ERR;
+    }
+    
+    CallaterRef ret = CallaterInvokeGID(func, NULL, delay, groupId);
+    if(CallaterRefError(ret))
+        return ret;
+    void *copy = CallaterPayloadOf(ret.ref);
+    if(copy == NULL)
+    {
+        CallaterCancel(ret);
+        return CALLATER_REF_ERR;
+    }
+    memcpy(copy, payload, size);
+    table.args[ret.ref] = copy;
     return ret;
 }
 
+#endif
+
 float CallaterInvokesAfter(CallaterRef ref)
 {
-    return table.invokeTimes[ref.ref] - CallaterCurrentTime();
+    if(table.invokeData[ref.ref].store == CALLATER_STORE_PAUSED)
+        return INFINITY;
+    uint64_t clock = table.invokeData[ref.ref].clock;
+    if(clock != 0)
+    {
+        // the clock moves at its current rate, but only on updates
+        float rate = CallaterClockRate(clock);
+        if(rate == 0)
+            return INFINITY;
+        return (CallaterDueTime(ref.ref) - table.clocks[clock].time) / rate - (CallaterNow() - table.lastUpdated);
+    }
+    return CallaterDueTime(ref.ref) - CallaterNow();
+}
+
+// to be called once after popping any number of invocations
+static void CallaterAfterCancel(bool minCancelled)
+{
+    if(table.count != 0 && table.funcs[table.count - 1] == CallaterNoop)
+    {
+        CallaterFindNewLastInvocation(table.count - 1);
+    }
+    if(minCancelled)
+    {
+        CallaterFindNewMinInvokeTime();
+    }
 }
 
-void CallaterCancelGID(uint64_t groupId)
+#ifndef CALLATER_NO_GROUPS
+
+void CallaterCancelGID(CallaterGroupId groupId)
 {
+    bool minCancelled = false;
     for(uint64_t i = 0 ; i < table.count ; i++)
     {
         if(table.invokeData[i].groupId == groupId)
         {
-            CallaterCancel((CallaterRef){i});
+            minCancelled |= CallaterDueTime(i) == table.minInvokeTime;
+            CallaterPopInvoke(i);
         }
     }
+    CallaterAfterCancel(minCancelled);
 }
 
+#endif
+
 void CallaterCancelFunc(void(*func)(void*, CallaterRef))
 {
+    bool minCancelled = false;
     for(uint64_t i = 0 ; i < table.count ; i++)
     {
         if(table.funcs[i] == func)
         {
-            CallaterCancel((CallaterRef){i});
+            minCancelled |= CallaterDueTime(i) == table.minInvokeTime;
+            CallaterPopInvoke(i);
         }
     }
+    CallaterAfterCancel(minCancelled);
 }
 
 CallaterRef CallaterFuncRef(void(*func)(void*, CallaterRef))
@@ -425,7 +2860,7 @@ CallaterRef CallaterFuncRef(void(*func)(void*, CallaterRef))
 
 void CallaterCancel(CallaterRef ref)
 {
-    bool isMinInvokeTime = table.invokeTimes[ref.ref] == table.minInvokeTime;
+    bool isMinInvokeTime = CallaterDueTime(ref.ref) == table.minInvokeTime;
     bool isLastInvocation = ref.ref == table.count - 1;
     
     CallaterPopInvoke(ref.ref);
@@ -440,6 +2875,19 @@ void CallaterCancel(CallaterRef ref)
     }
 }
 
+void CallaterCancelMany(const CallaterRef *refs, uint64_t n)
+{
+    bool minCancelled = false;
+    for(uint64_t i = 0 ; i < n ; i++)
+    {
+        minCancelled |= CallaterDueTime(refs[i].ref) == table.minInvokeTime;
+        CallaterPopInvoke(refs[i].ref);
+    }
+    CallaterAfterCancel(minCancelled);
+}
+
+#ifndef CALLATER_NO_REPEAT
+
 void CallaterStopRepeat(CallaterRef ref)
 {
     table.invokeData[ref.ref].repeatRate = -1;
@@ -455,6 +2903,23 @@ float CallaterGetRepeatRate(CallaterRef ref)
     return table.invokeData[ref.ref].repeatRate;
 }
 
+void CallaterSetRepeatPolicy(CallaterRef ref, CallaterRepeatPolicy policy)
+{
+    table.invokeData[ref.ref].repeatPolicy = policy;
+}
+
+CallaterRepeatPolicy CallaterGetRepeatPolicy(CallaterRef ref)
+{
+    return table.invokeData[ref.ref].repeatPolicy;
+}
+
+uint64_t CallaterGetMissed(CallaterRef ref)
+{
+    return ref.ref == table.missedSlot ? table.missed : 0;
+}
+
+#endif
+
 void CallaterSetFunc(CallaterRef ref, void(*func)(void*, CallaterRef))
 {
     table.funcs[ref.ref] = func;
@@ -467,25 +2932,27 @@ typeof(void(*)(void*, CallaterRef)) CallaterGetFunc(CallaterRef ref)
 
 void CallaterSetArg(CallaterRef ref, void *arg)
 {
-    table.args[ref.ref] = arg;
+    table.args[ref.ref] = CALLATER_ARG_PACK(arg);
 }
 
 void *CallaterGetArg(CallaterRef ref)
 {
-    return table.args[ref.ref];
+    return CALLATER_ARG_UNPACK(table.args[ref.ref]);
 }
 
-void CallaterSetGID(CallaterRef ref, uint64_t groupId)
+#ifndef CALLATER_NO_GROUPS
+
+void CallaterSetGID(CallaterRef ref, CallaterGroupId groupId)
 {
     table.invokeData[ref.ref].groupId = groupId;
 }
 
-uint64_t CallaterGetGID(CallaterRef ref)
+CallaterGroupId CallaterGetGID(CallaterRef ref)
 {
     return table.invokeData[ref.ref].groupId;
 }
 
-uint64_t CallaterGroupCount(uint64_t groupId)
+uint64_t CallaterGroupCount(CallaterGroupId groupId)
 {
     uint64_t count = 0;
     for(uint64_t i = 0 ; i < table.count ; i++)
@@ -495,7 +2962,7 @@ uint64_t CallaterGroupCount(uint64_t groupId)
     return count;
 }
 
-uint64_t CallaterGetGroupRefs(CallaterRef *refsOut, uint64_t groupId)
+uint64_t CallaterGetGroupRefs(CallaterRef *refsOut, CallaterGroupId groupId)
 {
     uint64_t count = 0;
     for(uint64_t i = 0 ; i < table.count ; i++)
@@ -509,89 +2976,310 @@ uint64_t CallaterGetGroupRefs(CallaterRef *refsOut, uint64_t groupId)
     return count;
 }
 
-void CallaterPause(CallaterRef ref)
+#ifndef CALLATER_NO_REPEAT
+
+void CallaterSetGroupRepeatRate(CallaterGroupId groupId, float newRepeatRate)
 {
-    if(table.invokeData[ref.ref].pausedIndex != (uint64_t)-1)
-        return;
-    
-    CallaterPauseArray *pauseArray = &table.pausedInvokes;
-    if(pauseArray->count >= pauseArray->cap)
+    for(uint64_t i = 0 ; i < table.count ; i++)
     {
-        pauseArray->cap *= 2;
-        pauseArray->pausedInvokes =
-        realloc(
-            pauseArray->pausedInvokes,
-            pauseArray->cap * sizeof(*pauseArray->pausedInvokes)
-        );
+        if(table.invokeData[i].groupId == groupId)
+        {
+            table.invokeData[i].repeatRate = newRepeatRate;
+        }
+    }
+}
+
+#endif
+
+void CallaterSetGroupFunc(CallaterGroupId groupId, void(*func)(void*, CallaterRef))
+{
+    for(uint64_t i = 0 ; i < table.count ; i++)
+    {
+        if(table.invokeData[i].groupId == groupId)
+        {
+            table.funcs[i] = func;
+        }
+    }
+}
+
+void CallaterSetGroupArg(CallaterGroupId groupId, void *arg)
+{
+    for(uint64_t i = 0 ; i < table.count ; i++)
+    {
+        if(table.invokeData[i].groupId == groupId)
+        {
+            table.args[i] = CALLATER_ARG_PACK(arg);
+        }
+    }
+}
+
+void CallaterShiftGroup(CallaterGroupId groupId, float dt)
+{
+    bool minShifted = false;
+    for(uint64_t i = 0 ; i < table.count ; i++)
+    {
+        if(table.invokeData[i].groupId != groupId)
+            continue;
+        
+        switch(table.invokeData[i].store)
+        {
+            case CALLATER_STORE_HOT:
+            case CALLATER_STORE_FAR:
+#ifndef CALLATER_NO_REPEAT
+            case CALLATER_STORE_COHORT:
+#endif
+            case CALLATER_STORE_CLOCK:
+            {
+                // a shifted invocation is out of its cohort's order, it goes back in once it's called
+                float invokeTime = table.invokeTimes[i];
+                minShifted |= CallaterDueTime(i) == table.minInvokeTime;
+                CallaterUnschedule(i);
+                CallaterSchedule(i, invokeTime + dt);
+                break;
+            }
+#ifndef CALLATER_NO_PAUSE
+            case CALLATER_STORE_PAUSED:
+                // the delay of a frame invocation isn't in seconds
+                if(!table.invokeData[i].frames)
+                {
+                    table.invokeTimes[i] = CallaterPausedTime(CallaterPausedDelay(table.invokeTimes[i]) + dt);
+                }
+                break;
+#endif
+            default:
+                break;
+        }
     }
     
-    float invokeTime = table.invokeTimes[ref.ref];
-    float delay = table.invokeTimes[ref.ref] - table.lastUpdated;
-    
-    pauseArray->pausedInvokes[pauseArray->count] = (CallaterPausedInvoke){.ref = ref, .delay = delay};
-    table.invokeData[ref.ref].pausedIndex = pauseArray->count;
-    table.invokeTimes[ref.ref] = INFINITY;
-    pauseArray->count += 1;
-    if(table.minInvokeTime == invokeTime)
+    // shifting back already lowered table.minInvokeTime when scheduling
+    if(minShifted && dt > 0)
     {
         CallaterFindNewMinInvokeTime();
     }
 }
 
-void CallaterPauseGID(uint64_t groupId)
+#endif
+
+#ifndef CALLATER_NO_PAUSE
+
+// no rescan of `table.minInvokeTime`, it's only a lower bound and the next tick that finds nothing due fixes it
+static void CallaterPauseSlot(uint64_t idx)
+{
+    uint8_t store = table.invokeData[idx].store;
+    if(store == CALLATER_STORE_PAUSED || store == CALLATER_STORE_NONE)
+        return;
+    
+    float delay = table.invokeTimes[idx] - CallaterClockNow(table.invokeData[idx].clock, table.lastUpdated);
+    if(store == CALLATER_STORE_FRAME)
+    {
+        delay = (CallaterIndex)(table.invokeData[idx].storeIndex - table.frame);
+    }
+    else if(table.invokeData[idx].frames)
+    {
+        // paused from its own callback: due again after its repeat rate, or on the next update if it doesn't repeat
+        delay = 1;
+#ifndef CALLATER_NO_REPEAT
+        if(!signbit(table.invokeData[idx].repeatRate))
+            delay = table.invokeData[idx].repeatRate;
+#endif
+    }
+    CallaterUnschedule(idx);
+    table.invokeData[idx].store = CALLATER_STORE_PAUSED;
+    table.invokeTimes[idx] = CallaterPausedTime(delay);
+}
+
+void CallaterPause(CallaterRef ref)
+{
+    CallaterPauseSlot(ref.ref);
+}
+
+#ifndef CALLATER_NO_GROUPS
+
+void CallaterPauseGID(CallaterGroupId groupId)
 {
     for(uint64_t i = 0 ; i < table.count ; i++)
     {
         if(table.invokeData[i].groupId == groupId)
         {
-            CallaterPause((CallaterRef){i});
+            CallaterPauseSlot(i);
         }
     }
 }
 
-static void CallaterRemovePause(uint64_t index)
+#endif
+
+void CallaterPauseMany(const CallaterRef *refs, uint64_t n)
+{
+    for(uint64_t i = 0 ; i < n ; i++)
+    {
+        CallaterPauseSlot(refs[i].ref);
+    }
+}
+
+// scheduling only ever lowers table.minInvokeTime, so resuming never needs a rescan
+static void CallaterResumeSlot(uint64_t idx, float curTime)
 {
-    CallaterPauseArray *pauseArray = &table.pausedInvokes;
-    pauseArray->pausedInvokes[index] = pauseArray->pausedInvokes[pauseArray->count - 1];
-    CallaterRef movedRef = pauseArray->pausedInvokes[index].ref;
-    table.invokeData[movedRef.ref].pausedIndex = index;
-    pauseArray->count -= 1;
+    if(table.invokeData[idx].store == CALLATER_STORE_PAUSED)
+    {
+        // it stays paused if there's no memory to put it back
+        const uint64_t clock = table.invokeData[idx].clock;
+        if(table.invokeData[idx].frames)
+        {
+            CallaterFramePush(idx, (uint64_t)CallaterPausedDelay(table.invokeTimes[idx]));
+            return;
+        }
+        if(!CallaterReserveStores(clock, 1))
+            return;
+        table.invokeData[idx].store = CALLATER_STORE_NONE;
+        CallaterSchedule(idx, CallaterPausedDelay(table.invokeTimes[idx]) + CallaterClockNow(clock, curTime));
+    }
 }
 
 void CallaterResume(CallaterRef ref)
 {
-    CallaterPauseArray *pauseArray = &table.pausedInvokes;
-    uint64_t index = table.invokeData[ref.ref].pausedIndex;
-    table.invokeData[ref.ref].pausedIndex = (uint64_t)-1;
-    if(index != (uint64_t)-1)
+    if(table.invokeData[ref.ref].store == CALLATER_STORE_PAUSED)
     {
-        CallaterPausedInvoke pi = pauseArray->pausedInvokes[index];
-        table.invokeTimes[ref.ref] = pi.delay + CallaterCurrentTime();
-        
-        CallaterRemovePause(index);
-        
-        // TODO only do this if this is lower than table.minInvokeTime
-        CallaterFindNewMinInvokeTime();
-        return;
+        CallaterResumeSlot(ref.ref, CallaterNow());
+    }
+}
+
+#ifndef CALLATER_NO_GROUPS
+
+void CallaterResumeGID(CallaterGroupId groupId)
+{
+    const float curTime = CallaterNow();
+    for(uint64_t i = 0 ; i < table.count ; i++)
+    {
+        if(table.invokeData[i].groupId == groupId)
+        {
+            CallaterResumeSlot(i, curTime);
+        }
+    }
+}
+
+#endif
+
+void CallaterResumeMany(const CallaterRef *refs, uint64_t n)
+{
+    const float curTime = CallaterNow();
+    for(uint64_t i = 0 ; i < n ; i++)
+    {
+        CallaterResumeSlot(refs[i].ref, curTime);
+    }
+}
+
+#endif
+
+CallaterClock CallaterClockCreate(CallaterClock parent)
+{
+    // clock heaps grow on their own, a fixed table has nowhere to put them
+    if(table.fixed || !CallaterClockValid(parent))
+        return CALLATER_CLOCK_ERR;
+    
+    for(uint32_t c = parent.id + 1 ; c < CALLATER_MAX_CLOCKS ; c++)
+    {
+        if(!table.clocks[c].alive)
+        {
+            table.clocks[c] = (CallaterClockState){.scale = 1, .parent = parent.id, .alive = true};
+            table.clockCount = c + 1 > table.clockCount ? c + 1 : table.clockCount;
+            return (CallaterClock){c};
+        }
     }
+    return CALLATER_CLOCK_ERR;
 }
 
-void CallaterResumeGID(uint64_t groupId)
+void CallaterClockDestroy(CallaterClock clock)
 {
-    CallaterPauseArray *pauseArray = &table.pausedInvokes;
-    for(uint64_t i = 0 ; i < pauseArray->count ; i++)
+    if(clock.id == 0 || !CallaterClockValid(clock))
+        return;
+    
+    // children always have a higher index than their parent
+    bool doomed[CALLATER_MAX_CLOCKS] = {0};
+    doomed[clock.id] = true;
+    for(uint64_t c = clock.id + 1 ; c < table.clockCount ; c++)
+    {
+        doomed[c] = table.clocks[c].alive && doomed[table.clocks[c].parent];
+    }
+    
+    // paused invocations are in no heap, so look through the whole table
+    for(uint64_t i = 0 ; i < table.count ; i++)
+    {
+        if(table.funcs[i] != CallaterNoop && doomed[table.invokeData[i].clock])
+        {
+            CallaterPopInvoke(i);
+        }
+    }
+    
+    for(uint64_t c = clock.id ; c < table.clockCount ; c++)
     {
-        if(CallaterGetGID(pauseArray->pausedInvokes[i].ref) == groupId)
+        if(doomed[c])
         {
-            CallaterResume(pauseArray->pausedInvokes[i].ref);
-            i -= 1;
+            CALLATER_RESIZE_ARRAY(table.clocks[c].heap.invokes, table.clocks[c].heap.cap, 0, _Alignof(CallaterFarInvoke));
+            table.clocks[c] = (CallaterClockState){0};
         }
     }
+    while(!table.clocks[table.clockCount - 1].alive)
+    {
+        table.clockCount -= 1;
+    }
+    
+    // invocations on child clocks never hold `table.minInvokeTime`
+    CallaterAfterCancel(false);
+}
+
+// the global clock always follows real time
+void CallaterClockSetScale(CallaterClock clock, float scale)
+{
+    if(clock.id != 0 && CallaterClockValid(clock))
+    {
+        table.clocks[clock.id].scale = fmaxf(scale, 0);
+    }
+}
+
+float CallaterClockGetScale(CallaterClock clock)
+{
+    return CallaterClockValid(clock) ? table.clocks[clock.id].scale : 0;
+}
+
+void CallaterClockPause(CallaterClock clock)
+{
+    if(clock.id != 0 && CallaterClockValid(clock))
+    {
+        table.clocks[clock.id].paused = true;
+    }
+}
+
+void CallaterClockResume(CallaterClock clock)
+{
+    if(CallaterClockValid(clock))
+    {
+        table.clocks[clock.id].paused = false;
+    }
+}
+
+bool CallaterClockPaused(CallaterClock clock)
+{
+    return CallaterClockValid(clock) && table.clocks[clock.id].paused;
+}
+
+float CallaterClockTime(CallaterClock clock)
+{
+    return clock.id == 0 ? CallaterNow() : table.clocks[clock.id].time;
+}
+
+CallaterClock CallaterGetClock(CallaterRef ref)
+{
+    return (CallaterClock){table.invokeData[ref.ref].clock};
+}
+
+bool CallaterClockError(CallaterClock clock)
+{
+    return clock.id == CALLATER_CLOCK_ERR.id;
 }
 
 bool CallaterRefError(CallaterRef ref)
 {
-    return ref.ref == (uint64_t)-1;
+    return ref.ref == CALLATER_NO_SLOT;
 }
 
 uint64_t CallaterCountNoop()
@@ -606,8 +3294,23 @@ uint64_t CallaterCountNoop()
 
 void CallaterShrinkToFit()
 {
-    uint64_t newCap = table.count + 1;
+    // the buffer of a fixed table belongs to the user
+    if(table.fixed)
+        return;
+    
+    // virtual tables keep their addresses and hand the pages past `newCap` back to the OS
+    uint64_t newCap = szmin(table.count + 1, CallaterCapLimit());
     CallaterReallocTable(newCap);
+    // the due list keeps its size, this may be called from a callback of the update using it
+    CallaterHotResize(table.hot.count);
+    CallaterFarResize(&table.far, table.far.count);
+    
+    CallaterPayloadSlab *slab = &table.payloads;
+    uint64_t usedBlocks = (table.count + CALLATER_PAYLOAD_BLOCK - 1) / CALLATER_PAYLOAD_BLOCK;
+    for(uint64_t i = usedBlocks ; i < slab->blockCount ; i++)
+    {
+        slab->blocks[i] = CallaterResize(slab->blocks[i], CALLATER_PAYLOAD_BLOCK * CALLATER_PAYLOAD_SIZE, 0, _Alignof(max_align_t));
+    }
     
 #if defined(DEBUG)
     assert(CallaterCountNoop() == table.noopCount);
@@ -616,10 +3319,32 @@ void CallaterShrinkToFit()
 
 void CallaterDeinit()
 {
-    free(table.funcs);
-    free(table.args);
-    free((char*)table.invokeTimes - table.delaysPtrOffset);
-    free(table.invokeData);
-    free(table.pausedInvokes.pausedInvokes);
+    // never initialized
+    if(table.allocator.free == NULL)
+        return;
+    
+    CallaterResizeTableArrays(table.cap, 0);
+    CallaterHotResize(0);
+    CallaterFarResize(&table.far, 0);
+    CallaterDueResize(0);
+    for(uint64_t c = 1 ; c < CALLATER_MAX_CLOCKS ; c++)
+    {
+        CALLATER_RESIZE_ARRAY(table.clocks[c].heap.invokes, table.clocks[c].heap.cap, 0, _Alignof(CallaterFarInvoke));
+    }
+    CALLATER_RESIZE_ARRAY(table.deferNext.slots, table.deferNext.cap, 0, _Alignof(CallaterIndex));
+    CALLATER_RESIZE_ARRAY(table.deferEndOfUpdate.slots, table.deferEndOfUpdate.cap, 0, _Alignof(CallaterIndex));
+    if(table.frameWheel != NULL)
+    {
+        for(uint64_t b = 0 ; b < CALLATER_FRAME_BUCKETS ; b++)
+        {
+            CALLATER_RESIZE_ARRAY(table.frameWheel[b].slots, table.frameWheel[b].cap, 0, _Alignof(CallaterIndex));
+        }
+        CALLATER_RESIZE_ARRAY(table.frameWheel, CALLATER_FRAME_BUCKETS, 0, _Alignof(CallaterDeferQueue));
+    }
+    for(uint64_t i = 0 ; i < table.payloads.blockCount ; i++)
+    {
+        CallaterResize(table.payloads.blocks[i], CALLATER_PAYLOAD_BLOCK * CALLATER_PAYLOAD_SIZE, 0, _Alignof(max_align_t));
+    }
+    CALLATER_RESIZE_ARRAY(table.payloads.blocks, table.payloads.blockCount, 0, _Alignof(unsigned char*));
     table = (CallaterTable){0};
 }
@@ -13,36 +13,263 @@
     
 #endif
 
-#define CALLATER_REF_ERR ((CallaterRef){(uint64_t)-1})
+// Define `CALLATER_COMPACT` (when compiling callater.c and everything including this header) to store slot indices, refs
+// and groupIds in 32 bits. An invocation takes 48 bytes instead of 64 to 68, but the table is limited to 2^32 - 1 invocations
+// Define `CALLATER_COMPACT_ARGS` to also store the args in 32 bits (44 bytes per invocation), they must then be handles
+// (e.g. indices cast to `void*`) rather than pointers, and `CallaterInvokeCopy` isn't available
+#ifdef CALLATER_COMPACT
+typedef uint32_t CallaterIndex;
+typedef uint32_t CallaterGroupId;
+#else
+typedef uint64_t CallaterIndex;
+typedef uint64_t CallaterGroupId;
+#endif
+
+// Define `CALLATER_NO_PAUSE`, `CALLATER_NO_GROUPS` or `CALLATER_NO_REPEAT` (again for callater.c and its includers) to strip
+// pausing, groups or repeating invocations: their functions below go away along with their per invocation fields and
+// the branches for them in `CallaterUpdate`. With `CALLATER_NO_GROUPS` the groupId given to the `GID` variants is ignored,
+// with `CALLATER_NO_REPEAT` so are the repeat rates given to the batch functions
+
+// Define `CALLATER_TSC` (for callater.c) on x86 to read the fine clock (precise invocations and `CallaterWait`) from the TSC,
+// calibrated against the OS clock in `CallaterInit`, which then busy waits for `CALLATER_TSC_CALIBRATION` seconds (0.002 by
+// default). The gain is resolution, not speed, so every other read stays on the coarse OS clock, which ticks every 1 to 4 ms on
+// Linux but is cheaper. The OS clock is used for all reads when the CPU doesn't report an invariant TSC
+
+#define CALLATER_REF_ERR ((CallaterRef){(CallaterIndex)-1})
 
 typedef struct CallaterRef
 {
-    uint64_t ref;
+    CallaterIndex ref;
 } CallaterRef;
 
+// A clock invocations can be bound to, see `CallaterClockCreate`
+typedef struct CallaterClock
+{
+    uint32_t id;
+} CallaterClock;
+
+// the clock every invocation is on by default, it follows real time
+#define CALLATER_CLOCK_GLOBAL ((CallaterClock){0})
+#define CALLATER_CLOCK_ERR    ((CallaterClock){(uint32_t)-1})
+
+// Memory callbacks used by the context, see `CallaterInitEx`
+// `realloc` and `free` always get the size and alignment the memory was allocated with
+typedef struct CallaterAllocator
+{
+    void *(*alloc)(uint64_t size, uint64_t alignment, void *user);
+    void *(*realloc)(void *ptr, uint64_t oldSize, uint64_t newSize, uint64_t alignment, void *user);
+    void (*free)(void *ptr, uint64_t size, uint64_t alignment, void *user);
+    void *user;
+} CallaterAllocator;
+
+typedef enum CallaterEngine
+{
+    CALLATER_ENGINE_ADAPTIVE,
+    CALLATER_ENGINE_LINEAR,
+    CALLATER_ENGINE_HEAP,
+} CallaterEngine;
+
+// How a repeating invocation is rescheduled, see `CallaterSetRepeatPolicy`
+typedef enum CallaterRepeatPolicy
+{
+    CALLATER_REPEAT_DELAY,    // `repeatRate` after the call, lateness adds up (the default)
+    CALLATER_REPEAT_CATCH_UP, // fixed rate, every missed period gets its own call
+    CALLATER_REPEAT_COALESCE, // fixed rate, missed periods are folded into one call, see `CallaterGetMissed`
+    CALLATER_REPEAT_SKIP,     // fixed rate, a call late by a whole period or more is dropped
+} CallaterRepeatPolicy;
+
 // initialize the Callater context
 void CallaterInit();
 
+// Same as `CallaterInit`, except every allocation of the context goes through `allocator`
+// `CallaterHugePageAllocator()` can be passed to back big tables with huge pages
+// `alloc` and `realloc` can return NULL (`realloc` leaving the old block as it was): the call that needed the memory fails
+// instead, an insert returns `CALLATER_REF_ERR` and `CallaterReserve` false, and the context is left as it was
+void CallaterInitEx(const CallaterAllocator *allocator);
+
+// Returns an allocator that maps allocations of at least `CALLATER_HUGE_PAGE_THRESHOLD` bytes with mmap and
+// MADV_HUGEPAGE, so scans over millions of slots don't thrash the TLB. Smaller ones use malloc
+// On platforms other than Linux this is the same as the default allocator
+const CallaterAllocator *CallaterHugePageAllocator();
+
+// Initializes the context inside the `size` bytes at `buffer`, no allocation ever happens afterwards:
+// the table never grows, and adding invocations once it's full returns `CALLATER_REF_ERR`
+// Returns the number of invocations that fit, 0 if the buffer is too small (and the context isn't initialized)
+// `buffer` must outlive the context, `CallaterDeinit` doesn't free it
+uint64_t CallaterInitFixed(void *buffer, uint64_t size);
+
+// Returns the buffer size `CallaterInitFixed` needs for `capacity` invocations
+uint64_t CallaterFixedBufferSize(uint64_t capacity);
+
+// Initializes the context with address space reserved up front for `maxCapacity` invocations
+// pages are committed as the table grows, so it never copies and pointers into it never move
+// `CallaterShrinkToFit` gives the unused pages back to the OS. Adding invocations past `maxCapacity`, or when the OS
+// can't commit more pages, returns `CALLATER_REF_ERR`
+// Returns false, leaving the context uninitialized, if virtual memory isn't supported on this platform (only Linux and
+// Windows are) or if the address space for `maxCapacity` invocations couldn't be reserved
+bool CallaterInitVirtual(uint64_t maxCapacity);
+
+// Grows the context at once so `n` invocations on the global clock fit without allocating, due at any time
+// Only the table, its time stores and the list of due invocations are grown: the heaps of other clocks, the queues of
+// `CallaterDefer`, the frame wheel and the payloads of `CallaterInvokeCopy` are still allocated when first needed
+// Returns false if the context was initialized with `CallaterInitFixed` and `n` is bigger than its capacity, or if the allocation failed
+bool CallaterReserve(uint64_t n);
+
 // Adds the function `func` to be called after `delay` time, with `arg` passed
 // Returns the reference to the invocation
 CallaterRef CallaterInvoke(void(*func)(void*, CallaterRef), void *arg, float delay);
 
 // Same as `CallaterInvoke`, except you can use `groupId` as a handle to the invocations
-// (e.g. when using `CallaterCancelGID(uint64_t groupId)`)
+// (e.g. when using `CallaterCancelGID(CallaterGroupId groupId)`)
 // Returns the reference to the invocation
 // NOTE groupId -1 is reserved
-CallaterRef CallaterInvokeGID(void(*func)(void*, CallaterRef), void *arg, float delay, uint64_t groupId);
+CallaterRef CallaterInvokeGID(void(*func)(void*, CallaterRef), void *arg, float delay, CallaterGroupId groupId);
+
+// Calls `func` at the start of the next `CallaterUpdate`, before any timed invocation, without going through the timers
+// Deferred calls run in the order they were added and cost no comparisons. The ref works like any other: it can be cancelled,
+// paused, or made repeating with `CallaterSetRepeatRate` (its repeats are then timed). Calls deferred from inside a deferred
+// call wait for the update after. With `CallaterInitFixed` it's an invocation with no delay instead
+CallaterRef CallaterDefer(void(*func)(void*, CallaterRef), void *arg);
 
+// Same as `CallaterDefer`, except `func` is called at the end of the current (or next, if called outside of one) `CallaterUpdate`
+// after the timed invocations
+CallaterRef CallaterDeferEndOfUpdate(void(*func)(void*, CallaterRef), void *arg);
+
+// Calls `func` on the `frames`th `CallaterUpdate` from now (0 counts as 1), whatever the time. Frame invocations sit in a wheel
+// of `CALLATER_FRAME_BUCKETS` (256 by default) buckets indexed by frame, each update only pops the bucket of its frame
+// Pausing one keeps its remaining frames. `CallaterInvokesAfter` doesn't apply to them
+// Returns `CALLATER_REF_ERR` if the context was initialized with `CallaterInitFixed`
+CallaterRef CallaterInvokeAfterFrames(void(*func)(void*, CallaterRef), void *arg, uint64_t frames);
+
+#ifndef CALLATER_NO_REPEAT
+// Calls `func` every `n` updates, starting `n` updates from now. Its repeat rate is in frames
+CallaterRef CallaterInvokeEveryNFrames(void(*func)(void*, CallaterRef), void *arg, uint64_t n);
+#endif
+
+// Returns the number of `CallaterUpdate` calls so far, which is what frame invocations count
+uint64_t CallaterGetFrame();
+
+#ifndef CALLATER_NO_REPEAT
 // Calls `func` after `firstDelay` seconds, then every `repeatRate` seconds
 // Returns the reference to the invocation
 CallaterRef CallaterInvokeRepeat(void(*func)(void*, CallaterRef), void *arg, float firstDelay, float repeatRate);
 
-CallaterRef CallaterInvokeRepeatGID(void(*func)(void*, CallaterRef), void *arg, float firstDelay, float repeatRate, uint64_t groupId);
+CallaterRef CallaterInvokeRepeatGID(void(*func)(void*, CallaterRef), void *arg, float firstDelay, float repeatRate, CallaterGroupId groupId);
+
+// Same as `CallaterInvokeRepeat`, except the first call is delayed further by a phase in [0, repeatRate) picked from the ref
+// The phases of consecutive refs spread evenly over the period, so lots of repeating invocations added at once with the same
+// rate don't all fire in the same update, forever
+CallaterRef CallaterInvokeRepeatStaggered(void(*func)(void*, CallaterRef), void *arg, float firstDelay, float repeatRate);
+
+// When enabled every repeating invocation added (by the `InvokeRepeat` functions or the batch functions) is staggered
+// like with `CallaterInvokeRepeatStaggered`
+void CallaterSetStaggerRepeats(bool enabled);
+
+bool CallaterGetStaggerRepeats();
+#endif
+
+// Same as `CallaterInvoke`, except the `size` bytes at `payload` are copied into memory owned by Callater
+// and `func` gets a pointer to that copy as its arg. The copy lives as long as the invocation, so no allocation is needed on your side
+// `size` can be up to `CALLATER_PAYLOAD_SIZE` (32 by default), returns `CALLATER_REF_ERR` if it's bigger
+#ifndef CALLATER_COMPACT_ARGS
+CallaterRef CallaterInvokeCopy(void(*func)(void*, CallaterRef), const void *payload, uint64_t size, float delay);
+
+CallaterRef CallaterInvokeCopyGID(void(*func)(void*, CallaterRef), const void *payload, uint64_t size, float delay, CallaterGroupId groupId);
+#endif
+
+// Adds `n` invocations at once, with a single clock read and at most one reallocation
+// invocation `i` calls `funcs[i]` with `args[i]` after `delays[i]` seconds
+// `args`, `repeatRates` and `groupIds` can be NULL for no arg, no repeat and no group
+// If `refsOut` isn't NULL it's filled with the `n` references
+void CallaterInvokeBatch(void(**funcs)(void*, CallaterRef), void **args, const float *delays, const float *repeatRates, const CallaterGroupId *groupIds, uint64_t n, CallaterRef *refsOut);
+
+// Same as `CallaterInvokeBatch` but every invocation calls `func` with the same delay, repeat rate and groupId
+// pass a negative `repeatRate` for no repeat
+void CallaterInvokeBatchArgs(void(*func)(void*, CallaterRef), void **args, float delay, float repeatRate, CallaterGroupId groupId, uint64_t n, CallaterRef *refsOut);
 
 // This must be called for the invocations added to actually get called
 // basically you should call this once every frame
 void CallaterUpdate();
 
+// Same as `CallaterUpdate`, but stops calling the due invocations after `maxCalls` of them or once `maxSeconds` passed
+// (checked with the fine clock after every call, pass INFINITY for no time limit). They're called the most overdue first,
+// in real time for those on clocks
+// and the rest are left due, to be called first on the next update. Returns how many were left
+uint64_t CallaterUpdateBudget(uint64_t maxCalls, float maxSeconds);
+
+// Same as `CallaterUpdate`, but time moves in steps of `dt` seconds: each substep calls what became due by its end, earliest
+// first, so a callback sees the time of its substep and invocations it adds count from there. Runs the whole steps that passed
+// since the last update, at most `maxSubsteps` of them. The steps past that are carried over, not dropped or merged: the next
+// calls run them first, so no substep is ever longer than `dt`, but time falls behind the clock until they caught up (keep
+// `maxSubsteps` above the steps a call usually has). Time that isn't a whole step is left for the next update too
+// Returns the substeps run
+uint64_t CallaterUpdateFixed(float dt, uint64_t maxSubsteps);
+
+// Puts the invocation in priority lane `lane`, from 0 (the default, called first) to `CALLATER_PRIORITY_LANES - 1` (4 lanes by default)
+// When an update has a budget the due invocations are called lane by lane, so the lower lanes are the ones deferred under load
+void CallaterSetPriority(CallaterRef ref, uint8_t lane);
+
+uint8_t CallaterGetPriority(CallaterRef ref);
+
+// Calls at most `maxCalls` invocations of `lane` per update, the others are deferred like with `CallaterUpdateBudget`
+// Pass UINT64_MAX (the default) for no limit
+void CallaterSetLaneBudget(uint8_t lane, uint64_t maxCalls);
+
+// Blocks until the next invocation is due or `maxSeconds` passed, whichever comes first, then `CallaterUpdate` should be called
+// Sleeps the whole way, unless precise invocations are pending: it then wakes up `CALLATER_SPIN_MARGIN` seconds early
+// (0.002 by default) and spins on the fine clock, so they fire within microseconds. Always sleeps the whole way with a time source
+// set by `CallaterSetTimeSource`. Returns at once when nothing is pending and `maxSeconds` is INFINITY, or while calls
+// from `CallaterDefer` or `CallaterInvokeAfterFrames` are pending, since only updates move those along
+void CallaterWait(float maxSeconds);
+
+// Invocations due further than `seconds` from the last update are kept in a separate sorted store
+// and only moved to the scanned array once they get close, so long delays cost nothing per update
+// Defaults to `CALLATER_DEFAULT_HORIZON`
+void CallaterSetHorizon(float seconds);
+
+float CallaterGetHorizon();
+
+// Picks how the pending invocations are indexed:
+// `CALLATER_ENGINE_LINEAR` scans the invocations due within the horizon with SIMD, best for a few thousand dense timers
+// `CALLATER_ENGINE_HEAP` keeps them in a binary heap, best for lots of sparse timers
+// `CALLATER_ENGINE_ADAPTIVE` (the default) watches the load and moves the invocations between the two
+void CallaterSetEngine(CallaterEngine engine);
+
+// Returns the engine currently in use, never `CALLATER_ENGINE_ADAPTIVE`
+CallaterEngine CallaterGetEngine();
+
+// Makes the context read the time (in seconds) from `now` instead of the OS clock, e.g. to feed it the frame time of your engine
+// `user` is passed to `now`, pass NULL to go back to the OS clock. Set it right after initializing, times already scheduled aren't converted
+void CallaterSetTimeSource(float(*now)(void *user), void *user);
+
+// When enabled, adding and resuming invocations and `CallaterInvokesAfter` use the time of the last `CallaterUpdate` instead of
+// reading the clock, so it's read once per update. Delays are then relative to the start of the update rather than the exact call
+void CallaterSetFrameTime(bool enabled);
+
+bool CallaterGetFrameTime();
+
+// Same as `CallaterInvoke`, except the invocation is precise: its delay counts from a fine clock read
+// and while precise invocations are pending `CallaterUpdate` reads the fine clock too. On Linux the default clock only ticks every 1 to 4 ms
+CallaterRef CallaterInvokePrecise(void(*func)(void*, CallaterRef), void *arg, float delay);
+
+// Makes the referenced invocation precise or not, see `CallaterInvokePrecise`
+void CallaterSetPrecise(CallaterRef ref, bool precise);
+
+bool CallaterGetPrecise(CallaterRef ref);
+
+// Lets the invocation be called up to `seconds` after its invoke time (0 for no slack): its invoke times get rounded up
+// to multiples of the biggest power of two that's at most `seconds`. Invocations that round to the same grid point share
+// an invoke time, so they're called by the same update and `CallaterWait` wakes up once for them. It's rounding, not
+// a search for the fewest wake ups: windows that overlap can still land on neighbouring grid points
+// Applies to the current invoke time and every time a repeating invocation is rescheduled
+void CallaterSetSlack(CallaterRef ref, float seconds);
+
+// Returns the grid the invoke times of the invocation are rounded to, 0 if it has no slack
+float CallaterGetSlack(CallaterRef ref);
+
+// Slack of the invocations added from now on, except precise ones. 0 (the default) for no slack
+void CallaterSetDefaultSlack(float seconds);
+
 // Returns the seconds from now to when the invocation will happen
 float CallaterInvokesAfter(CallaterRef ref);
 
@@ -56,18 +283,33 @@ CallaterRef CallaterFuncRef(void(*func)(void*, CallaterRef));
 // Remove all occurances of `func` from being invoked
 void CallaterCancelFunc(void(*func)(void*, CallaterRef));
 
+#ifndef CALLATER_NO_PAUSE
 // pausing API
 void CallaterPause(CallaterRef ref);
-void CallaterPauseGID(uint64_t groupId);
 void CallaterResume(CallaterRef ref);
-void CallaterResumeGID(uint64_t groupId);
+#ifndef CALLATER_NO_GROUPS
+void CallaterPauseGID(CallaterGroupId groupId);
+void CallaterResumeGID(CallaterGroupId groupId);
+#endif
 
+// Same as calling `CallaterPause`/`CallaterResume` on each of the `n` refs, but the next invocation time
+// is only recomputed once and resuming reads the clock once
+void CallaterPauseMany(const CallaterRef *refs, uint64_t n);
+void CallaterResumeMany(const CallaterRef *refs, uint64_t n);
+#endif
+
+#ifndef CALLATER_NO_GROUPS
 // Remove all invocations associated with `groupId`
-void CallaterCancelGID(uint64_t groupId);
+void CallaterCancelGID(CallaterGroupId groupId);
+#endif
 
 // Removes the referenced invocation
 void CallaterCancel(CallaterRef ref);
 
+// Removes the `n` referenced invocations, cheaper than calling `CallaterCancel` on each
+void CallaterCancelMany(const CallaterRef *refs, uint64_t n);
+
+#ifndef CALLATER_NO_REPEAT
 // Stops the referenced invocation from repeating
 void CallaterStopRepeat(CallaterRef ref);
 
@@ -77,6 +319,18 @@ void CallaterSetRepeatRate(CallaterRef ref, float newRepeatRate);
 
 float CallaterGetRepeatRate(CallaterRef ref);
 
+// With any policy but `CALLATER_REPEAT_DELAY` the invocation repeats at a fixed rate: it's rescheduled to its last invoke time
+// plus `repeatRate` rather than to the time it was called plus `repeatRate`, so it doesn't drift. After a hitch the periods
+// it missed are called one after the other, coalesced into one call, or skipped, depending on `policy`
+void CallaterSetRepeatPolicy(CallaterRef ref, CallaterRepeatPolicy policy);
+
+CallaterRepeatPolicy CallaterGetRepeatPolicy(CallaterRef ref);
+
+// Inside the callback of a `CALLATER_REPEAT_COALESCE` invocation, returns the number of periods it missed and that this call stands for
+// Returns 0 anywhere else
+uint64_t CallaterGetMissed(CallaterRef ref);
+#endif
+
 // Changes the function to be invoked
 void CallaterSetFunc(CallaterRef ref, void(*func)(void*, CallaterRef));
 
@@ -87,17 +341,70 @@ void CallaterSetArg(CallaterRef ref, void *arg);
 
 void *CallaterGetArg(CallaterRef ref);
 
+#ifndef CALLATER_NO_GROUPS
 // Changes the groupId of the referenced invocation
-void CallaterSetGID(CallaterRef ref, uint64_t groupId);
+void CallaterSetGID(CallaterRef ref, CallaterGroupId groupId);
 
-uint64_t CallaterGetGID(CallaterRef ref);
+CallaterGroupId CallaterGetGID(CallaterRef ref);
 
 // Returns the number of invocations associated with `groupId`
-uint64_t CallaterGroupCount(uint64_t groupId);
+uint64_t CallaterGroupCount(CallaterGroupId groupId);
 
 // Fills the array `refsOut` with the invocation references associated with `groupId`
 // Returns the number of references that were added to the pointer
-uint64_t CallaterGetGroupRefs(CallaterRef *refsOut, uint64_t groupId);
+uint64_t CallaterGetGroupRefs(CallaterRef *refsOut, CallaterGroupId groupId);
+
+// Same as calling `CallaterSetRepeatRate`, `CallaterSetFunc` or `CallaterSetArg` on every invocation associated with `groupId`
+// in a single pass over the table
+#ifndef CALLATER_NO_REPEAT
+void CallaterSetGroupRepeatRate(CallaterGroupId groupId, float newRepeatRate);
+#endif
+void CallaterSetGroupFunc(CallaterGroupId groupId, void(*func)(void*, CallaterRef));
+void CallaterSetGroupArg(CallaterGroupId groupId, void *arg);
+
+// Delays every invocation associated with `groupId` by `dt` seconds (or brings them closer if negative)
+// paused invocations get `dt` added to their remaining delay
+void CallaterShiftGroup(CallaterGroupId groupId, float dt);
+#endif
+
+// Creates a clock that runs on `parent` (`CALLATER_CLOCK_GLOBAL` for real time): every update it moves by as much as its parent
+// did times its scale, and not at all while it or one of its ancestors is paused. Its time starts at 0
+// Invocations on a clock are due when its time reaches theirs, so pausing or scaling a clock is O(1) however many invocations it holds
+// Returns `CALLATER_CLOCK_ERR` if `CALLATER_MAX_CLOCKS` (16 by default, the global clock included) are already alive,
+// or with a context initialized by `CallaterInitFixed`
+CallaterClock CallaterClockCreate(CallaterClock parent);
+
+// Cancels every invocation on `clock` and on its children, then destroys them all
+void CallaterClockDestroy(CallaterClock clock);
+
+// `scale` is clamped to 0, the global clock can't be scaled or paused
+void CallaterClockSetScale(CallaterClock clock, float scale);
+
+// Returns 0 if `clock` was destroyed or isn't a clock
+float CallaterClockGetScale(CallaterClock clock);
+
+void CallaterClockPause(CallaterClock clock);
+void CallaterClockResume(CallaterClock clock);
+
+// Only looks at `clock` itself, not its ancestors. Returns false if `clock` was destroyed or isn't a clock
+bool CallaterClockPaused(CallaterClock clock);
+
+// Returns the time of `clock` as of the last `CallaterUpdate` (the current time for the global clock)
+float CallaterClockTime(CallaterClock clock);
+
+// Same as `CallaterInvoke`, but `delay` is in the time of `clock`
+// Returns `CALLATER_REF_ERR` if `clock` isn't alive
+CallaterRef CallaterInvokeClock(void(*func)(void*, CallaterRef), void *arg, float delay, CallaterClock clock);
+
+#ifndef CALLATER_NO_REPEAT
+CallaterRef CallaterInvokeRepeatClock(void(*func)(void*, CallaterRef), void *arg, float firstDelay, float repeatRate, CallaterClock clock);
+#endif
+
+// Returns the clock the invocation is on
+CallaterClock CallaterGetClock(CallaterRef ref);
+
+// Returns whether this clock is an error
+bool CallaterClockError(CallaterClock clock);
 
 // Shrinks the context to match size, in case you want lower memory usage
 void CallaterShrinkToFit();
@@ -1,3 +1,7 @@
+// callater.c is included below, this lets it use mremap
+#define _GNU_SOURCE
+// and this the TSC, where there is one
+#define CALLATER_TSC
 #include "../callater.h"
 #include <stdio.h>
 #include <stdbool.h>
@@ -47,6 +51,16 @@ void MultiCallback(void* arg, CallaterRef ref) {
     multi_callback_count++;
 }
 
+// Number of slots currently paused
+uint64_t CountPaused() {
+    uint64_t count = 0;
+    for(uint64_t i = 0 ; i < table.count ; i++)
+    {
+        count += table.invokeData[i].store == CALLATER_STORE_PAUSED;
+    }
+    return count;
+}
+
 // =====================
 // Existing Tests
 // =====================
@@ -133,6 +147,34 @@ void TestImmediateInvocation() {
     ASSERT(basic_callback_count == 1);
 }
 
+void TestNegativeDelay() {
+    TEST("Negative delay");
+    setup();
+    
+    // a negative delay is overdue, it must not become a repeat rate
+    CallaterRef ref = CallaterInvoke(BasicCallback, NULL, -1.0f);
+    void (*funcs[2])(void*, CallaterRef) = { BasicCallback, BasicCallback };
+    const float delays[2] = { -0.5f, 0.25f };
+    CallaterRef batch[2];
+    CallaterInvokeBatch(funcs, NULL, delays, NULL, NULL, 2, batch);
+    ASSERT(CallaterGetRepeatRate(ref) < 0.0f && CallaterGetRepeatRate(batch[0]) < 0.0f);
+    
+    mock_current_time = 0.5f;
+    CallaterUpdate();
+    ASSERT(basic_callback_count == 3);
+    mock_current_time = 3.0f;
+    CallaterUpdate();
+    ASSERT(basic_callback_count == 3);
+    
+    // paused while overdue: clamped to no delay left
+    ref = CallaterInvoke(MultiCallback, NULL, -1.0f);
+    CallaterPause(ref);
+    ASSERT(signbit(table.invokeTimes[ref.ref]) && CallaterPausedDelay(table.invokeTimes[ref.ref]) == 0.0f);
+    CallaterResume(ref);
+    CallaterUpdate();
+    ASSERT(multi_callback_count == 1);
+}
+
 void TestReferenceManagement() {
     TEST("Reference management");
     setup();
@@ -559,6 +601,1237 @@ void TestCancelPausedInvocation() {
     ASSERT(basic_callback_count == 0);
 }
 
+void TestFarHorizon() {
+    TEST("Far invocations stay out of the hot array");
+    setup();
+    CallaterSetHorizon(1.0f);
+    
+    CallaterInvoke(BasicCallback, NULL, 0.05f);
+    CallaterRef far = CallaterInvoke(RepeatCallback, NULL, 300.0f);
+    CallaterRef cancelled = CallaterInvoke(MultiCallback, NULL, 200.0f);
+    ASSERT(table.hot.count == 1 && table.far.count == 2);
+    
+    CallaterCancel(cancelled);
+    ASSERT(table.far.count == 1);
+    
+    mock_current_time = 0.1f;
+    CallaterUpdate();
+    ASSERT(basic_callback_count == 1 && table.hot.count == 0);
+    
+    // promoted once it's within the horizon, but not called yet
+    mock_current_time = 299.5f;
+    CallaterUpdate();
+    ASSERT(table.far.count == 0 && table.hot.count == 1);
+    ASSERT(repeat_callback_count == 0);
+    ASSERT(CallaterInvokesAfter(far) > 0.0f);
+    
+    mock_current_time = 300.0f;
+    CallaterUpdate();
+    ASSERT(repeat_callback_count == 1 && multi_callback_count == 0);
+}
+
+void TestFarRepeatAndPause() {
+    TEST("Far repeating invocation and pausing");
+    setup();
+    CallaterSetHorizon(1.0f);
+    
+    CallaterRef ref = CallaterInvokeRepeat(RepeatCallback, NULL, 5.0f, 10.0f);
+    CallaterPause(ref);
+    ASSERT(table.far.count == 0);
+    
+    mock_current_time = 20.0f;
+    CallaterUpdate();
+    CallaterResume(ref);
+    ASSERT(table.far.count == 1);
+    
+    mock_current_time = 25.0f;
+    CallaterUpdate();
+    ASSERT(repeat_callback_count == 1);
+    ASSERT(table.hot.count == 0);
+    
+    mock_current_time = 35.0f;
+    CallaterUpdate();
+    ASSERT(repeat_callback_count == 2);
+}
+
+void TestRepeatCohorts() {
+    TEST("Repeating invocations share a cohort per repeat rate");
+    setup();
+    
+    CallaterRef refs[4];
+    for(int i = 0 ; i < 4 ; i++)
+    {
+        refs[i] = CallaterInvokeRepeat(RepeatCallback, NULL, 0.1f * i, 1.0f);
+    }
+    CallaterInvokeRepeat(GroupCallback, NULL, 0.0f, 0.5f);
+    
+    mock_current_time = 0.5f;
+    CallaterUpdate();
+    ASSERT(repeat_callback_count == 4 && group_callback_count == 1);
+    ASSERT(table.hot.count == 0);
+    
+    uint64_t cohort = table.invokeData[refs[0].ref].cohort;
+    ASSERT(table.cohorts[cohort].count == 4);
+    ASSERT(table.invokeData[table.cohorts[cohort].first].cohort == cohort);
+    
+    // cancelling from the middle of a cohort
+    CallaterCancel(refs[2]);
+    ASSERT(table.cohorts[cohort].count == 3);
+    
+    // changing the rate moves it to another cohort once it's called
+    CallaterSetRepeatRate(refs[1], 0.5f);
+    mock_current_time = 1.5f;
+    CallaterUpdate();
+    ASSERT(repeat_callback_count == 7);
+    ASSERT(table.cohorts[cohort].count == 2);
+    ASSERT(table.invokeData[refs[1].ref].cohort != cohort);
+    
+    mock_current_time = 2.0f;
+    CallaterUpdate();
+    ASSERT(repeat_callback_count == 8);
+}
+
+void TestHeapEngine() {
+    TEST("Heap engine");
+    setup();
+    
+    CallaterInvoke(BasicCallback, NULL, 0.5f);
+    CallaterSetEngine(CALLATER_ENGINE_HEAP);
+    ASSERT(CallaterGetEngine() == CALLATER_ENGINE_HEAP);
+    ASSERT(table.hot.count == 0 && table.far.count == 1);
+    
+    CallaterRef cancelled = CallaterInvoke(MultiCallback, NULL, 0.2f);
+    CallaterInvokeRepeat(RepeatCallback, NULL, 0.1f, 1.0f);
+    CallaterCancel(cancelled);
+    
+    mock_current_time = 0.6f;
+    CallaterUpdate();
+    ASSERT(basic_callback_count == 1 && repeat_callback_count == 1 && multi_callback_count == 0);
+    
+    CallaterInvoke(BasicCallback, NULL, 0.1f);
+    CallaterSetEngine(CALLATER_ENGINE_LINEAR);
+    ASSERT(table.hot.count == 1 && table.far.count == 0);
+    
+    mock_current_time = 1.6f;
+    CallaterUpdate();
+    ASSERT(basic_callback_count == 2 && repeat_callback_count == 2);
+}
+
+void TestAdaptiveEngine() {
+    TEST("Adaptive engine switches with the load");
+    setup();
+    
+    CallaterRef refs[CALLATER_ADAPTIVE_HEAP_COUNT];
+    for(int i = 0 ; i < CALLATER_ADAPTIVE_HEAP_COUNT ; i++)
+    {
+        refs[i] = CallaterInvoke(MultiCallback, NULL, 1.0f + i * 0.001f);
+    }
+    
+    // nothing due, so the heap takes over
+    for(int i = 0 ; i < CALLATER_ADAPTIVE_PERIOD ; i++)
+    {
+        CallaterUpdate();
+    }
+    ASSERT(CallaterGetEngine() == CALLATER_ENGINE_HEAP);
+    
+    // dropping most of the invocations goes back to the linear scan
+    for(int i = 0 ; i < CALLATER_ADAPTIVE_HEAP_COUNT - 100 ; i++)
+    {
+        CallaterCancel(refs[i]);
+    }
+    for(int i = 0 ; i < CALLATER_ADAPTIVE_PERIOD ; i++)
+    {
+        CallaterUpdate();
+    }
+    ASSERT(CallaterGetEngine() == CALLATER_ENGINE_LINEAR);
+    
+    mock_current_time = 100.0f;
+    CallaterUpdate();
+    ASSERT(multi_callback_count == 100);
+}
+
+void TestInvokeBatch() {
+    TEST("Batch invoke");
+    setup();
+    
+    enum { N = 100 };
+    void(*funcs[N])(void*, CallaterRef);
+    void *args[N];
+    float delays[N];
+    float repeatRates[N];
+    CallaterGroupId groupIds[N];
+    CallaterRef refs[N];
+    int data[N];
+    for(int i = 0 ; i < N ; i++)
+    {
+        funcs[i] = i % 2 == 0 ? BasicCallback : RepeatCallback;
+        args[i] = &data[i];
+        delays[i] = i * 0.01f;
+        repeatRates[i] = i % 2 == 0 ? -1.0f : 1.0f;
+        groupIds[i] = i % 3;
+    }
+    
+    // leave a hole so the batch doesn't start at slot 0
+    CallaterCancel(CallaterInvoke(MultiCallback, NULL, 1.0f));
+    CallaterInvoke(MultiCallback, NULL, 5.0f);
+    
+    CallaterInvokeBatch(funcs, args, delays, repeatRates, groupIds, N, refs);
+    ASSERT(CallaterGetArg(refs[10]) == &data[10]);
+    ASSERT(CallaterGetGID(refs[10]) == 1);
+    ASSERT(CallaterGetRepeatRate(refs[11]) == 1.0f);
+    ASSERT(CallaterGroupCount(2) == N / 3);
+    
+    mock_current_time = 0.5f;
+    CallaterUpdate();
+    ASSERT(basic_callback_count == 26 && repeat_callback_count == 25);
+    
+    mock_current_time = 1.0f;
+    CallaterUpdate();
+    ASSERT(basic_callback_count == 50 && repeat_callback_count == 50);
+    
+    CallaterRef argRefs[N];
+    CallaterInvokeBatchArgs(GroupCallback, args, 0.5f, -1.0f, 7, N, argRefs);
+    ASSERT(CallaterGetArg(argRefs[N - 1]) == &data[N - 1]);
+    ASSERT(CallaterGroupCount(7) == N);
+    
+    mock_current_time = 1.5f;
+    CallaterUpdate();
+    ASSERT(group_callback_count == N && multi_callback_count == 0);
+    
+    // regular invokes still fill holes correctly afterwards
+    for(int i = 0 ; i < N ; i++)
+    {
+        CallaterInvoke(MultiCallback, NULL, 0.0f);
+    }
+    mock_current_time = 2.0f;
+    CallaterUpdate();
+    ASSERT(multi_callback_count == N);
+}
+
+void TestManyRefs() {
+    TEST("Cancel, pause and resume many refs");
+    setup();
+    
+    enum { N = 64 };
+    CallaterRef refs[N];
+    for(int i = 0 ; i < N ; i++)
+    {
+        refs[i] = CallaterInvoke(MultiCallback, NULL, 0.5f + i * 0.01f);
+    }
+    CallaterRef kept = CallaterInvoke(BasicCallback, NULL, 1.0f);
+    
+    // every other one gets cancelled, the rest get paused
+    CallaterRef cancelled[N / 2];
+    CallaterRef paused[N / 2];
+    for(int i = 0 ; i < N / 2 ; i++)
+    {
+        cancelled[i] = refs[i * 2];
+        paused[i] = refs[i * 2 + 1];
+    }
+    CallaterCancelMany(cancelled, N / 2);
+    CallaterPauseMany(paused, N / 2);
+    // pausing doesn't rescan, the min is only a lower bound until the next update
+    ASSERT(table.minInvokeTime <= table.invokeTimes[kept.ref]);
+    ASSERT(CountPaused() == N / 2);
+    ASSERT(CallaterInvokesAfter(paused[0]) == INFINITY);
+    
+    mock_current_time = 2.0f;
+    CallaterUpdate();
+    ASSERT(multi_callback_count == 0 && basic_callback_count == 1);
+    ASSERT(table.count == N);
+    ASSERT(table.minInvokeTime == INFINITY);
+    
+    CallaterResumeMany(paused, N / 2);
+    ASSERT(CountPaused() == 0);
+    ASSERT(table.minInvokeTime == 2.0f + 0.51f);
+    
+    mock_current_time = 4.0f;
+    CallaterUpdate();
+    ASSERT(multi_callback_count == N / 2);
+    ASSERT(table.count == 0);
+}
+
+void TestGroupMutators() {
+    TEST("Group-wide mutators");
+    setup();
+    
+    const uint64_t GROUP_ID = 55;
+    int data = 1;
+    CallaterRef repeating = CallaterInvokeRepeatGID(GroupCallback, NULL, 0.5f, 1.0f, GROUP_ID);
+    CallaterRef far = CallaterInvokeGID(GroupCallback, NULL, 10.0f, GROUP_ID);
+    CallaterRef paused = CallaterInvokeGID(GroupCallback, NULL, 1.0f, GROUP_ID);
+    CallaterRef other = CallaterInvoke(BasicCallback, NULL, 1.0f);
+    CallaterPause(paused);
+    
+    CallaterSetGroupArg(GROUP_ID, &data);
+    CallaterSetGroupRepeatRate(GROUP_ID, 2.0f);
+    ASSERT(CallaterGetArg(far) == &data && CallaterGetArg(paused) == &data && CallaterGetArg(other) == NULL);
+    ASSERT(CallaterGetRepeatRate(repeating) == 2.0f && CallaterGetRepeatRate(other) < 0);
+    CallaterSetGroupRepeatRate(GROUP_ID, -1.0f);
+    CallaterSetRepeatRate(repeating, 2.0f);
+    
+    CallaterShiftGroup(GROUP_ID, 1.0f);
+    ASSERT(table.invokeTimes[repeating.ref] == 1.5f);
+    ASSERT(table.invokeTimes[far.ref] == 11.0f);
+    ASSERT(CallaterPausedDelay(table.invokeTimes[paused.ref]) == 2.0f);
+    ASSERT(table.minInvokeTime == 1.0f);
+    
+    mock_current_time = 1.0f;
+    CallaterUpdate();
+    ASSERT(group_callback_count == 0 && basic_callback_count == 1);
+    
+    mock_current_time = 1.5f;
+    CallaterUpdate();
+    ASSERT(group_callback_count == 1);
+    
+    // shifting back out of the cohort
+    CallaterShiftGroup(GROUP_ID, -2.0f);
+    ASSERT(table.invokeTimes[repeating.ref] == 1.5f);
+    CallaterSetGroupFunc(GROUP_ID, MultiCallback);
+    mock_current_time = 9.0f;
+    CallaterUpdate();
+    ASSERT(multi_callback_count == 2 && group_callback_count == 1);
+}
+
+static int payload_sum = 0;
+
+void PayloadCallback(void* arg, CallaterRef ref) {
+    int *payload = arg;
+    payload_sum += payload[0] + payload[1];
+}
+
+void TestInvokeCopy() {
+    TEST("Invoke with copied payload");
+    setup();
+    payload_sum = 0;
+    
+    int big[CALLATER_PAYLOAD_SIZE];
+    ASSERT(CallaterRefError(CallaterInvokeCopy(PayloadCallback, big, sizeof(big), 0.5f)));
+    
+    CallaterRef refs[300];
+    for(int i = 0 ; i < 300 ; i++)
+    {
+        int payload[2] = {i, 1};
+        refs[i] = CallaterInvokeCopy(PayloadCallback, payload, sizeof(payload), 0.5f);
+    }
+    // growing the table must not move the payloads
+    int *first = CallaterGetArg(refs[0]);
+    ASSERT(first[0] == 0 && first[1] == 1);
+    ASSERT(((int*)CallaterGetArg(refs[299]))[0] == 299);
+    
+    mock_current_time = 1.0f;
+    CallaterUpdate();
+    ASSERT(payload_sum == 299 * 300 / 2 + 300);
+    
+    // recycled slots get the new payload
+    int payload[2] = {1000, 0};
+    CallaterRef ref = CallaterInvokeCopy(PayloadCallback, payload, sizeof(payload), 0.5f);
+    ASSERT(((int*)CallaterGetArg(ref))[0] == 1000);
+    
+    CallaterShrinkToFit();
+    ASSERT(table.payloads.blocks[1] == NULL);
+}
+
+static uint64_t allocated_bytes = 0;
+
+void *CountingAlloc(uint64_t size, uint64_t alignment, void *user) {
+    *(uint64_t*)user += 1;
+    allocated_bytes += size;
+    return CallaterDefaultAlloc(size, alignment, NULL);
+}
+
+void *CountingRealloc(void *ptr, uint64_t oldSize, uint64_t newSize, uint64_t alignment, void *user) {
+    *(uint64_t*)user += 1;
+    allocated_bytes += newSize - oldSize;
+    return CallaterDefaultRealloc(ptr, oldSize, newSize, alignment, NULL);
+}
+
+void CountingFree(void *ptr, uint64_t size, uint64_t alignment, void *user) {
+    *(uint64_t*)user += 1;
+    allocated_bytes -= size;
+    CallaterDefaultFree(ptr, size, alignment, NULL);
+}
+
+void TestCustomAllocator() {
+    TEST("Custom allocator");
+    setup();
+    CallaterDeinit();
+    
+    uint64_t calls = 0;
+    allocated_bytes = 0;
+    CallaterAllocator allocator = {
+        .alloc = CountingAlloc,
+        .realloc = CountingRealloc,
+        .free = CountingFree,
+        .user = &calls,
+    };
+    CallaterInitEx(&allocator);
+    ASSERT(calls > 0 && allocated_bytes > 0);
+    
+    for(int i = 0 ; i < 1000 ; i++)
+    {
+        CallaterInvokeCopy(MultiCallback, &i, sizeof(i), 0.5f);
+    }
+    ASSERT(table.hot.invokeTimes != NULL && ((uintptr_t)table.hot.invokeTimes % 32) == 0);
+    CallaterPause((CallaterRef){0});
+    mock_current_time = 1.0f;
+    CallaterUpdate();
+    ASSERT(multi_callback_count == 999);
+    
+    CallaterDeinit();
+    ASSERT(allocated_bytes == 0);
+    
+    CallaterInitEx(CallaterHugePageAllocator());
+    for(int i = 0 ; i < 200000 ; i++)
+    {
+        CallaterInvoke(MultiCallback, NULL, 0.5f);
+    }
+    mock_current_time = 2.0f;
+    CallaterUpdate();
+    ASSERT(multi_callback_count == 999 + 200000);
+}
+
+// the allocation `fail_alloc_in` counts down to fails, the ones after it work again. 0 never fails
+static uint64_t fail_alloc_in = 0;
+
+void *FailingAlloc(uint64_t size, uint64_t alignment, void *user) {
+    if(fail_alloc_in != 0 && --fail_alloc_in == 0)
+        return NULL;
+    return CountingAlloc(size, alignment, user);
+}
+
+void *FailingRealloc(void *ptr, uint64_t oldSize, uint64_t newSize, uint64_t alignment, void *user) {
+    if(fail_alloc_in != 0 && --fail_alloc_in == 0)
+        return NULL;
+    return CountingRealloc(ptr, oldSize, newSize, alignment, user);
+}
+
+void TestAllocationFailure() {
+    TEST("Allocation failure");
+    setup();
+    CallaterDeinit();
+    
+    uint64_t calls = 0;
+    allocated_bytes = 0;
+    CallaterAllocator allocator = {
+        .alloc = FailingAlloc,
+        .realloc = FailingRealloc,
+        .free = CountingFree,
+        .user = &calls,
+    };
+    CallaterInitEx(&allocator);
+    while(table.count < table.cap)
+    {
+        CallaterInvoke(MultiCallback, NULL, 0.5f);
+    }
+    
+    // the growth fails at each of its allocations in turn, every time the table is left as it was.
+    // The lanes get room first, a failed table growth would keep the hot array's
+    ASSERT(CallaterHotReserve(1));
+    const uint64_t cap = table.cap, count = table.count;
+    uint64_t failed = 0, intact = 0;
+    for(uint64_t n = 1 ; ; n++)
+    {
+        const uint64_t bytes = allocated_bytes;
+        fail_alloc_in = n;
+        if(!CallaterRefError(CallaterInvoke(MultiCallback, NULL, 0.5f)))
+            break;
+        failed += 1;
+        intact += table.cap == cap && table.count == count && allocated_bytes == bytes;
+    }
+    ASSERT(failed > 0 && intact == failed);
+    ASSERT(table.cap > cap && table.count == count + 1);
+    
+    fail_alloc_in = 1;
+    ASSERT(!CallaterReserve(table.cap * 4));
+    
+    void *args[300] = {0};
+    CallaterRef refs[300];
+    fail_alloc_in = 1;
+    CallaterInvokeBatchArgs(MultiCallback, args, 0.5f, -1.0f, CALLATER_NO_GROUP, 300, refs);
+    ASSERT(CallaterRefError(refs[0]) && CallaterRefError(refs[299]) && table.count == count + 1);
+    
+    CallaterClock clock = CallaterClockCreate(CALLATER_CLOCK_GLOBAL);
+    fail_alloc_in = 1;
+    ASSERT(CallaterRefError(CallaterInvokeClock(MultiCallback, NULL, 0.5f, clock)));
+    fail_alloc_in = 1;
+    ASSERT(CallaterRefError(CallaterDefer(MultiCallback, NULL)));
+    fail_alloc_in = 1;
+    ASSERT(CallaterRefError(CallaterInvokeAfterFrames(MultiCallback, NULL, 1)));
+    int payload = 0;
+    fail_alloc_in = 1;
+    ASSERT(CallaterRefError(CallaterInvokeCopy(MultiCallback, &payload, sizeof(payload), 0.5f)));
+    
+    // nothing that failed got in, everything that was added still runs
+    mock_current_time = 1.0f;
+    CallaterUpdate();
+    CallaterUpdate();
+    ASSERT(multi_callback_count == count + 1);
+    
+    CallaterDeinit();
+    ASSERT(allocated_bytes == 0);
+}
+
+void TestStoreSizes() {
+    TEST("Stores sized by their own counts");
+    setup();
+    
+    // all of them are far, the hot array and the due list don't grow with them
+    for(int i = 0 ; i < 1000 ; i++)
+    {
+        CallaterInvoke(MultiCallback, NULL, 10.0f);
+    }
+    ASSERT(table.cap >= 1000 && table.far.cap >= 1000);
+    ASSERT(table.hot.cap < 1000 && table.dueCap == 0);
+    
+    // then they all become due at once
+    mock_current_time = 10.0f;
+    CallaterUpdate();
+    ASSERT(multi_callback_count == 1000 && table.dueCap >= 1000);
+    
+    CallaterShrinkToFit();
+    ASSERT(table.hot.cap == 0 && table.far.cap == 0);
+}
+
+void TestReserveAndFixed() {
+    TEST("Reserve and fixed capacity");
+    setup();
+    CallaterDeinit();
+    
+    uint64_t calls = 0;
+    allocated_bytes = 0;
+    CallaterAllocator allocator = {
+        .alloc = CountingAlloc,
+        .realloc = CountingRealloc,
+        .free = CountingFree,
+        .user = &calls,
+    };
+    CallaterInitEx(&allocator);
+    ASSERT(CallaterReserve(1000));
+    uint64_t reservedCalls = calls;
+    for(int i = 0 ; i < 1000 ; i++)
+    {
+        CallaterRef ref = CallaterInvoke(MultiCallback, NULL, 0.5f);
+        CallaterPause(ref);
+    }
+    ASSERT(calls == reservedCalls);
+    CallaterDeinit();
+    
+    static _Alignas(64) unsigned char buffer[64 * 1024];
+    uint64_t cap = CallaterInitFixed(buffer, sizeof(buffer));
+    ASSERT(cap > 0 && CallaterFixedBufferSize(cap) <= sizeof(buffer));
+    // and it's the most that fit, whatever an invocation takes in this build
+    ASSERT(CallaterFixedBufferSize(cap + 1) > sizeof(buffer));
+    ASSERT((unsigned char*)table.dueSlots >= buffer && (unsigned char*)table.dueSlots < buffer + sizeof(buffer));
+    ASSERT(!CallaterReserve(cap + 1));
+    
+    uint64_t errors = 0;
+    for(uint64_t i = 0 ; i < cap ; i++)
+    {
+        int payload = (int)i;
+        errors += CallaterRefError(CallaterInvokeCopy(MultiCallback, &payload, sizeof(payload), 0.5f));
+    }
+    ASSERT(errors == 0);
+    ASSERT(CallaterRefError(CallaterInvoke(MultiCallback, NULL, 0.5f)));
+    CallaterRef refs[2];
+    CallaterInvokeBatchArgs(MultiCallback, (void*[]){NULL, NULL}, 0.5f, -1, (CallaterGroupId)-1, 2, refs);
+    ASSERT(CallaterRefError(refs[0]) && CallaterRefError(refs[1]));
+    ASSERT(table.count == cap);
+    
+    mock_current_time = 1.0f;
+    CallaterUpdate();
+    ASSERT(multi_callback_count == cap);
+    
+    // slots are recycled once called
+    ASSERT(!CallaterRefError(CallaterInvoke(MultiCallback, NULL, 0.5f)));
+    CallaterShrinkToFit();
+    ASSERT(table.cap == cap);
+    CallaterDeinit();
+    
+    ASSERT(CallaterInitFixed(buffer, 16) == 0);
+    CallaterDeinit();
+}
+
+void TestVirtualTable() {
+    TEST("Virtual memory table");
+    setup();
+    CallaterDeinit();
+    
+    ASSERT(CallaterInitVirtual(1 << 20));
+    float *invokeTimes = table.invokeTimes;
+    CallaterInvokeData *invokeData = table.invokeData;
+    for(int i = 0 ; i < 100000 ; i++)
+    {
+        CallaterRef ref = CallaterInvoke(MultiCallback, NULL, 0.5f + (i % 8));
+        if(i % 100 == 0)
+            CallaterPause(ref);
+    }
+    ASSERT(table.cap >= 100000 && table.invokeTimes == invokeTimes && table.invokeData == invokeData);
+    
+    mock_current_time = 10.0f;
+    CallaterUpdate();
+    ASSERT(multi_callback_count == 99000);
+    CallaterShrinkToFit();
+    ASSERT(table.invokeTimes == invokeTimes);
+    CallaterDeinit();
+    
+    ASSERT(CallaterInitVirtual(100));
+    for(int i = 0 ; i < 100 ; i++)
+    {
+        CallaterInvoke(MultiCallback, NULL, 0.5f);
+    }
+    ASSERT(CallaterRefError(CallaterInvoke(MultiCallback, NULL, 0.5f)));
+    ASSERT(!CallaterReserve(101));
+    CallaterShrinkToFit();
+    ASSERT(table.cap == 100);
+    CallaterDeinit();
+    
+    // more address space than the process has, it fails up front instead of on the first insert
+    ASSERT(!CallaterInitVirtual(1ULL << 46) && table.funcs == NULL);
+    ASSERT(CallaterInitVirtual(100) && !CallaterRefError(CallaterInvoke(MultiCallback, NULL, 0.5f)));
+    CallaterDeinit();
+}
+
+void TestCompactMode() {
+    TEST("Compact mode");
+    setup();
+    
+#ifdef CALLATER_COMPACT
+    ASSERT(sizeof(CallaterRef) == 4);
+    ASSERT(sizeof(CallaterInvokeData) <= 20);
+    ASSERT(sizeof(CallaterFarInvoke) == 8);
+#endif
+    ASSERT(CallaterRefError(CALLATER_REF_ERR));
+    
+    // cohort links use the all ones index as their end marker
+    CallaterRef a = CallaterInvokeRepeatGID(MultiCallback, NULL, 0.5f, 1.0f, 7);
+    CallaterRef b = CallaterInvokeRepeatGID(MultiCallback, NULL, 0.5f, 1.0f, 7);
+    mock_current_time = 0.5f;
+    CallaterUpdate();
+    CallaterCancel(a);
+    mock_current_time = 1.5f;
+    CallaterUpdate();
+    ASSERT(multi_callback_count == 3);
+    ASSERT(CallaterGetGID(b) == 7 && CallaterGroupCount(7) == 1);
+    ASSERT(CallaterGetGID(CallaterInvoke(MultiCallback, NULL, 1.0f)) == (CallaterGroupId)-1);
+}
+
+void TestPauseInTimeLane() {
+    TEST("Pause tagged in the time lane");
+    setup();
+    
+    CallaterRef due = CallaterInvoke(MultiCallback, NULL, 0.0f);
+    CallaterRef later = CallaterInvoke(MultiCallback, NULL, 1.5f);
+    
+    // already due: paused with no delay left
+    CallaterPause(due);
+    CallaterPause(later);
+    ASSERT(signbit(table.invokeTimes[due.ref]) && CallaterPausedDelay(table.invokeTimes[due.ref]) == 0.0f);
+    ASSERT(CallaterPausedDelay(table.invokeTimes[later.ref]) == 1.5f);
+    ASSERT(table.hot.count == 0);
+    
+    mock_current_time = 5.0f;
+    CallaterUpdate();
+    ASSERT(multi_callback_count == 0);
+    
+    CallaterResume(due);
+    CallaterResume(later);
+    CallaterUpdate();
+    ASSERT(multi_callback_count == 1);
+    mock_current_time = 6.5f;
+    CallaterUpdate();
+    ASSERT(multi_callback_count == 2);
+}
+
+void TestClocks() {
+    TEST("Clocks with scale and pause");
+    setup();
+    
+    CallaterClock game = CallaterClockCreate(CALLATER_CLOCK_GLOBAL);
+    CallaterClock slowZone = CallaterClockCreate(game);
+    ASSERT(!CallaterClockError(game) && !CallaterClockError(slowZone));
+    CallaterClockSetScale(slowZone, 0.5f);
+    
+    CallaterRef onGame = CallaterInvokeClock(MultiCallback, NULL, 1.0f, game);
+    CallaterRef onSlow = CallaterInvokeClock(MultiCallback, NULL, 1.0f, slowZone);
+    CallaterInvokeRepeatClock(RepeatCallback, NULL, 1.0f, 1.0f, game);
+    ASSERT(CallaterGetClock(onSlow).id == slowZone.id && table.invokeData[onGame.ref].store == CALLATER_STORE_CLOCK);
+    ASSERT(table.minInvokeTime == INFINITY);
+    
+    mock_current_time = 1.0f;
+    CallaterUpdate();
+    ASSERT(multi_callback_count == 1 && repeat_callback_count == 1);
+    ASSERT(CallaterClockTime(slowZone) == 0.5f);
+    ASSERT(CallaterInvokesAfter(onSlow) == 1.0f);
+    
+    // pausing the parent stops the child too, without touching the invocations
+    CallaterClockPause(game);
+    ASSERT(CallaterInvokesAfter(onSlow) == INFINITY);
+    // even one that's already due waits
+    CallaterInvokeClock(BasicCallback, NULL, 0.0f, slowZone);
+    mock_current_time = 5.0f;
+    CallaterUpdate();
+    ASSERT(multi_callback_count == 1 && repeat_callback_count == 1 && basic_callback_count == 0);
+    
+    CallaterClockResume(game);
+    mock_current_time = 6.0f;
+    CallaterUpdate();
+    ASSERT(multi_callback_count == 2 && repeat_callback_count == 2 && basic_callback_count == 1);
+    
+    // pausing one invocation keeps its delay in the time of its clock
+    CallaterRef paused = CallaterInvokeClock(GroupCallback, NULL, 1.0f, slowZone);
+    CallaterPause(paused);
+    mock_current_time = 10.0f;
+    CallaterUpdate();
+    CallaterResume(paused);
+    ASSERT(CallaterInvokesAfter(paused) == 2.0f);
+    
+    // destroying a clock cancels the invocations of its children
+    CallaterClockPause(slowZone);
+    CallaterClockDestroy(game);
+    ASSERT(CallaterClockGetScale(slowZone) == 0 && !CallaterClockPaused(slowZone));
+    ASSERT(CallaterClockGetScale((CallaterClock){CALLATER_MAX_CLOCKS}) == 0 && !CallaterClockPaused((CallaterClock){CALLATER_MAX_CLOCKS}));
+    ASSERT(CallaterFuncRef(GroupCallback).ref == CALLATER_REF_ERR.ref && CallaterFuncRef(RepeatCallback).ref == CALLATER_REF_ERR.ref);
+    ASSERT(table.clockCount == 1 && CallaterRefError(CallaterInvokeClock(MultiCallback, NULL, 1.0f, slowZone)));
+    
+    CallaterInvoke(BasicCallback, NULL, 1.0f);
+    mock_current_time = 11.0f;
+    CallaterUpdate();
+    ASSERT(basic_callback_count == 2 && group_callback_count == 0);
+}
+
+static float frame_source_time = 0.0f;
+static int frame_source_reads = 0;
+
+float FrameSource(void *user) {
+    frame_source_reads++;
+    return *(float*)user;
+}
+
+void TestFrameTime() {
+    TEST("Frame time inserts and time source hook");
+    setup();
+    
+    frame_source_time = 100.0f;
+    CallaterSetTimeSource(FrameSource, &frame_source_time);
+    CallaterSetFrameTime(true);
+    ASSERT(CallaterGetFrameTime());
+    
+    frame_source_time = 101.0f;
+    CallaterUpdate();
+    frame_source_reads = 0;
+    
+    // the source moved on, but every insert is relative to the last update
+    frame_source_time = 101.5f;
+    CallaterRef refs[500];
+    for(int i = 0 ; i < 500 ; i++)
+    {
+        refs[i] = CallaterInvoke(MultiCallback, NULL, 1.0f);
+    }
+    CallaterPause(refs[0]);
+    CallaterResume(refs[0]);
+    ASSERT(frame_source_reads == 0);
+    ASSERT(table.invokeTimes[refs[499].ref] == 102.0f && CallaterInvokesAfter(refs[0]) == 1.0f);
+    
+    frame_source_time = 102.0f;
+    CallaterUpdate();
+    ASSERT(frame_source_reads == 1 && multi_callback_count == 500);
+}
+
+#ifdef CALLATER_HAS_TSC
+
+void TestTsc() {
+    TEST("TSC calibration and monotonicity");
+    setup();
+    // the tests read the mock time, the TSC is checked directly
+    table.startSec = (uint64_t)CallaterFineSeconds();
+    CallaterCalibrateTsc();
+    if(table.tscPeriod == 0)
+    {
+        printf("TSC isn't invariant, skipped\n");
+        return;
+    }
+    
+    // on the timebase of the OS clock, and ticking at its rate
+    const double osStart = CallaterFineSeconds() - table.startSec;
+    const float tscStart = CallaterTscTime();
+    ASSERT(fabs(tscStart - osStart) < 0.001);
+    
+    uint64_t decreases = 0;
+    float prev = tscStart;
+    while(CallaterFineSeconds() - table.startSec - osStart < 0.05)
+    {
+        const float now = CallaterTscTime();
+        decreases += now < prev;
+        prev = now;
+    }
+    const double osElapsed = CallaterFineSeconds() - table.startSec - osStart;
+    ASSERT(decreases == 0);
+    ASSERT(fabs((CallaterTscTime() - tscStart) - osElapsed) < 0.001);
+}
+
+#endif
+
+void TestPrecise() {
+    TEST("Precise invocations and waiting");
+    setup();
+    
+    CallaterRef once = CallaterInvokePrecise(MultiCallback, NULL, 1.0f);
+    CallaterRef repeat = CallaterInvokeRepeat(RepeatCallback, NULL, 1.0f, 1.0f);
+    CallaterSetPrecise(repeat, true);
+    CallaterSetPrecise(repeat, true);
+    ASSERT(CallaterGetPrecise(once) && table.preciseCount == 2);
+    
+    mock_current_time = 1.0f;
+    CallaterUpdate();
+    ASSERT(multi_callback_count == 1 && repeat_callback_count == 1);
+    // the repeating one stays precise
+    ASSERT(table.preciseCount == 1 && CallaterGetPrecise(repeat));
+    
+    // already due, so no sleeping or spinning
+    mock_current_time = 3.0f;
+    CallaterWait(INFINITY);
+    CallaterCancel(repeat);
+    ASSERT(table.preciseCount == 0);
+    
+    // nothing pending
+    CallaterWait(INFINITY);
+    CallaterWait(0.001f);
+    ASSERT(CallaterNextDueTime() == INFINITY);
+    
+    // a time source that only moves between frames is never spun on
+    frame_source_time = 3.0f;
+    CallaterSetTimeSource(FrameSource, &frame_source_time);
+    CallaterInvokePrecise(MultiCallback, NULL, 0.5f);
+    CallaterWait(0.001f);
+    ASSERT(multi_callback_count == 1);
+}
+
+static double WallSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void TestWaitPending() {
+    TEST("Waiting with calls pending for the next update");
+    setup();
+    
+    // the timed one is far off, but the deferred one is due at the next update
+    CallaterInvoke(MultiCallback, NULL, 10.0f);
+    CallaterDefer(MultiCallback, NULL);
+    ASSERT(CallaterNextDueTime() <= mock_current_time);
+    
+    const double start = WallSeconds();
+    CallaterWait(1.0f);
+    ASSERT(WallSeconds() - start < 0.5);
+    
+    CallaterUpdate();
+    ASSERT(multi_callback_count == 1 && CallaterNextDueTime() == 10.0f);
+    
+    // same for an invocation counted in frames, until it's cancelled
+    CallaterRef frames = CallaterInvokeAfterFrames(MultiCallback, NULL, 3);
+    ASSERT(CallaterNextDueTime() <= mock_current_time);
+    CallaterCancel(frames);
+    ASSERT(CallaterNextDueTime() == 10.0f);
+    
+    CallaterInvokeAfterFrames(MultiCallback, NULL, 1);
+    CallaterUpdate();
+    ASSERT(multi_callback_count == 2 && CallaterNextDueTime() == 10.0f);
+}
+
+static uint64_t last_missed = 0;
+
+void MissedCallback(void* arg, CallaterRef ref) {
+    multi_callback_count++;
+    last_missed = CallaterGetMissed(ref);
+}
+
+void MissedCancelCallback(void* arg, CallaterRef ref) {
+    MissedCallback(arg, ref);
+    CallaterCancel(ref);
+}
+
+void TestRepeatPolicies() {
+    TEST("Fixed rate repeat policies");
+    setup();
+    
+    CallaterRef delayed  = CallaterInvokeRepeat(RepeatCallback, NULL, 1.0f, 1.0f);
+    CallaterRef catchUp  = CallaterInvokeRepeat(GroupCallback, NULL, 1.0f, 1.0f);
+    CallaterRef coalesce = CallaterInvokeRepeat(MissedCallback, NULL, 1.0f, 1.0f);
+    CallaterRef skip     = CallaterInvokeRepeat(BasicCallback, NULL, 1.0f, 1.0f);
+    CallaterSetRepeatPolicy(catchUp, CALLATER_REPEAT_CATCH_UP);
+    CallaterSetRepeatPolicy(coalesce, CALLATER_REPEAT_COALESCE);
+    CallaterSetRepeatPolicy(skip, CALLATER_REPEAT_SKIP);
+    ASSERT(CallaterGetRepeatPolicy(delayed) == CALLATER_REPEAT_DELAY && CallaterGetRepeatPolicy(skip) == CALLATER_REPEAT_SKIP);
+    
+    // half a period late: the delayed one drifts, the fixed rate ones stay on the grid
+    mock_current_time = 1.5f;
+    CallaterUpdate();
+    ASSERT(repeat_callback_count == 1 && group_callback_count == 1 && multi_callback_count == 1 && basic_callback_count == 1);
+    ASSERT(table.invokeTimes[delayed.ref] == 2.5f && table.invokeTimes[catchUp.ref] == 2.0f && table.invokeTimes[skip.ref] == 2.0f);
+    
+    // a hitch that misses 2 whole periods
+    mock_current_time = 4.2f;
+    CallaterUpdate();
+    ASSERT(repeat_callback_count == 2 && group_callback_count == 4);
+    ASSERT(multi_callback_count == 2 && last_missed == 2 && CallaterGetMissed(coalesce) == 0);
+    ASSERT(basic_callback_count == 1);
+    ASSERT(table.invokeTimes[catchUp.ref] == 5.0f && table.invokeTimes[coalesce.ref] == 5.0f && table.invokeTimes[skip.ref] == 5.0f);
+    
+    mock_current_time = 5.0f;
+    CallaterUpdate();
+    ASSERT(basic_callback_count == 2 && last_missed == 0);
+    
+    // a callback that cancels itself leaves nothing behind for the next user of its slot
+    CallaterRef others[] = {delayed, catchUp, coalesce, skip};
+    CallaterCancelMany(others, 4);
+    CallaterRef cancels = CallaterInvokeRepeat(MissedCancelCallback, NULL, 1.0f, 1.0f);
+    CallaterSetRepeatPolicy(cancels, CALLATER_REPEAT_COALESCE);
+    mock_current_time = 8.5f;
+    CallaterUpdate();
+    ASSERT(last_missed == 2);
+    CallaterRef reused = CallaterInvoke(BasicCallback, NULL, 1.0f);
+    ASSERT(reused.ref == cancels.ref && CallaterGetMissed(reused) == 0);
+}
+
+void TestUpdateBudget() {
+    TEST("Budgeted update carries the backlog");
+    setup();
+    
+    float delays[10];
+    void(*funcs[10])(void*, CallaterRef);
+    CallaterRef refs[10];
+    for(int i = 0 ; i < 10 ; i++)
+    {
+        // due in reverse order of insertion
+        delays[i] = 1.0f - i * 0.05f;
+        funcs[i] = MultiCallback;
+    }
+    CallaterInvokeBatch(funcs, NULL, delays, NULL, NULL, 10, refs);
+    CallaterRef repeat = CallaterInvokeRepeat(RepeatCallback, NULL, 0.1f, 0.5f);
+    
+    mock_current_time = 1.0f;
+    ASSERT(CallaterUpdateBudget(4, INFINITY) == 7);
+    ASSERT(multi_callback_count == 3 && repeat_callback_count == 1);
+    // the earliest were called, the latest are still due
+    ASSERT(table.invokeData[refs[9].ref].store == CALLATER_STORE_NONE && table.invokeData[refs[0].ref].store == CALLATER_STORE_HOT);
+    
+    // the backlog goes before the repeat that just became due
+    mock_current_time = 1.6f;
+    ASSERT(CallaterUpdateBudget(7, INFINITY) == 1);
+    ASSERT(multi_callback_count == 10 && repeat_callback_count == 1);
+    
+    ASSERT(CallaterUpdateBudget(0, INFINITY) == 1);
+    ASSERT(CallaterUpdateBudget(10, 1.0f) == 0 && repeat_callback_count == 2);
+    CallaterCancel(repeat);
+    
+    // a clock 4 times as fast, made at 1.6: due at its 3.0, so at 2.35. Later than the global one at 2.8 even though 3.0 > 2.8
+    CallaterClock fast = CallaterClockCreate(CALLATER_CLOCK_GLOBAL);
+    CallaterClockSetScale(fast, 4.0f);
+    CallaterInvokeClock(GroupCallback, NULL, 3.0f, fast);
+    CallaterInvoke(BasicCallback, NULL, 1.2f);
+    mock_current_time = 3.0f;
+    ASSERT(CallaterUpdateBudget(1, INFINITY) == 1);
+    ASSERT(group_callback_count == 1 && basic_callback_count == 0);
+}
+
+void TestPriorityLanes() {
+    TEST("Priority lanes and lane budgets");
+    setup();
+    
+    CallaterRef cosmetic[4];
+    for(int i = 0 ; i < 4 ; i++)
+    {
+        // cosmetic ones are due first
+        cosmetic[i] = CallaterInvoke(BasicCallback, NULL, 0.5f);
+        CallaterSetPriority(cosmetic[i], 3);
+    }
+    for(int i = 0 ; i < 4 ; i++)
+    {
+        CallaterInvoke(MultiCallback, NULL, 1.0f);
+    }
+    CallaterSetPriority(cosmetic[0], 200);
+    ASSERT(CallaterGetPriority(cosmetic[0]) == CALLATER_PRIORITY_LANES - 1);
+    
+    // the critical lane goes first even though it's due later
+    mock_current_time = 1.0f;
+    ASSERT(CallaterUpdateBudget(5, INFINITY) == 3);
+    ASSERT(multi_callback_count == 4 && basic_callback_count == 1);
+    
+    CallaterSetLaneBudget(3, 2);
+    CallaterUpdate();
+    ASSERT(basic_callback_count == 3);
+    CallaterSetLaneBudget(3, UINT64_MAX);
+    ASSERT(!table.laneBudgeted);
+    CallaterUpdate();
+    ASSERT(basic_callback_count == 4);
+}
+
+void TestStaggeredRepeats() {
+    TEST("Staggered repeat phases");
+    setup();
+    
+    for(int i = 0 ; i < 1000 ; i++)
+    {
+        CallaterInvokeRepeatStaggered(RepeatCallback, NULL, 0.0f, 1.0f);
+    }
+    
+    // every tenth of the period gets about a tenth of the calls
+    int minCalls = 1000, maxCalls = 0;
+    for(int step = 1 ; step <= 10 ; step++)
+    {
+        int before = repeat_callback_count;
+        mock_current_time = step * 0.1f;
+        CallaterUpdate();
+        int calls = repeat_callback_count - before;
+        minCalls = calls < minCalls ? calls : minCalls;
+        maxCalls = calls > maxCalls ? calls : maxCalls;
+    }
+    ASSERT(repeat_callback_count == 1000);
+    ASSERT(minCalls >= 90 && maxCalls <= 110);
+    
+    setup();
+    CallaterSetStaggerRepeats(true);
+    ASSERT(CallaterGetStaggerRepeats());
+    CallaterRef once = CallaterInvoke(BasicCallback, NULL, 1.0f);
+    CallaterRef refs[16];
+    CallaterInvokeBatchArgs(MultiCallback, NULL, 1.0f, 2.0f, CALLATER_NO_GROUP, 16, refs);
+    CallaterRef repeat = CallaterInvokeRepeat(RepeatCallback, NULL, 1.0f, 2.0f);
+    ASSERT(table.invokeTimes[once.ref] == 1.0f);
+    ASSERT(table.invokeTimes[refs[1].ref] == 1.0f + 2.0f * CallaterStaggerPhase(refs[1].ref));
+    ASSERT(table.invokeTimes[repeat.ref] == 1.0f + 2.0f * CallaterStaggerPhase(repeat.ref));
+    ASSERT(table.invokeTimes[repeat.ref] < 3.0f);
+}
+
+void TestSlack() {
+    TEST("Slack rounds invoke times to a grid");
+    setup();
+    
+    // a grid of 1/16th of a second
+    CallaterSetDefaultSlack(0.1f);
+    CallaterRef refs[10];
+    for(int i = 0 ; i < 10 ; i++)
+    {
+        refs[i] = CallaterInvoke(MultiCallback, NULL, 0.01f * (i + 1));
+    }
+    ASSERT(CallaterGetSlack(refs[0]) == 0.0625f);
+    int offGrid = 0;
+    for(int i = 0 ; i < 10 ; i++)
+    {
+        float invokeTime = CallaterDueTime(refs[i].ref);
+        offGrid += invokeTime < 0.01f * (i + 1) || (invokeTime != 0.0625f && invokeTime != 0.125f);
+    }
+    ASSERT(offGrid == 0);
+    
+    CallaterRef precise = CallaterInvokePrecise(BasicCallback, NULL, 0.01f);
+    ASSERT(CallaterGetSlack(precise) == 0 && table.invokeTimes[precise.ref] == 0.01f);
+    
+    // repeats stay on the grid, and setting the slack moves the current time
+    CallaterSetDefaultSlack(0);
+    CallaterRef repeat = CallaterInvokeRepeat(RepeatCallback, NULL, 0.3f, 0.3f);
+    ASSERT(CallaterDueTime(repeat.ref) == 0.3f);
+    CallaterSetSlack(repeat, 0.25f);
+    ASSERT(CallaterDueTime(repeat.ref) == 0.5f && table.invokeTimes[repeat.ref] == 0.3f);
+    
+    mock_current_time = 0.5f;
+    CallaterUpdate();
+    ASSERT(multi_callback_count == 10 && repeat_callback_count == 1);
+    ASSERT(CallaterDueTime(repeat.ref) == 0.75f);
+    
+    // the slack doesn't add up, it still averages its rate: 0.3, 0.6, ... 2.7
+    for(mock_current_time = 0.75f ; mock_current_time < 2.9f ; mock_current_time += 0.25f)
+    {
+        CallaterUpdate();
+    }
+    ASSERT(repeat_callback_count == 9);
+}
+
+static char defer_log[16];
+static int defer_log_len = 0;
+
+// logs the char `arg` points to
+void LogCallback(void* arg, CallaterRef ref) {
+    if(defer_log_len < 15)
+        defer_log[defer_log_len++] = *(char*)arg;
+}
+
+void DeferAgainCallback(void* arg, CallaterRef ref) {
+    LogCallback(arg, ref);
+    CallaterDefer(LogCallback, arg);
+}
+
+void TestDefer() {
+    TEST("Deferred calls");
+    setup();
+    defer_log_len = 0;
+    memset(defer_log, 0, sizeof(defer_log));
+    
+    static char n = 'N', e = 'E', t = 'T', a = 'A', c = 'C';
+    CallaterDeferEndOfUpdate(LogCallback, &e);
+    CallaterInvoke(LogCallback, &t, 0);
+    CallaterDefer(LogCallback, &n);
+    CallaterDefer(DeferAgainCallback, &a);
+    CallaterRef cancelled = CallaterDefer(LogCallback, &e);
+    CallaterCancel(cancelled);
+    // takes the cancelled slot, whose stale entry in the queue must not call it twice
+    CallaterRef reused = CallaterDefer(LogCallback, &c);
+    ASSERT(reused.ref == cancelled.ref);
+    
+    // next update calls come first in order, then the timed ones, then end of update ones
+    CallaterUpdate();
+    ASSERT(strcmp(defer_log, "NACTE") == 0);
+    
+    // deferred from a deferred call
+    CallaterUpdate();
+    ASSERT(strcmp(defer_log, "NACTEA") == 0);
+    
+    // a deferred call can be made repeating
+    CallaterRef repeat = CallaterDefer(RepeatCallback, NULL);
+    CallaterSetRepeatRate(repeat, 1.0f);
+    CallaterUpdate();
+    ASSERT(repeat_callback_count == 1);
+    mock_current_time = 1.0f;
+    CallaterUpdate();
+    ASSERT(repeat_callback_count == 2 && CallaterGetRepeatRate(repeat) == 1.0f);
+    
+    // lots of them grow the ring
+    for(int i = 0 ; i < 200 ; i++)
+    {
+        CallaterDefer(MultiCallback, NULL);
+    }
+    CallaterUpdate();
+    ASSERT(multi_callback_count == 200);
+}
+
+void TestFrameInvocations() {
+    TEST("Frame invocations");
+    setup();
+    
+    // frames count updates, not time
+    CallaterRef once = CallaterInvokeAfterFrames(BasicCallback, NULL, 3);
+    CallaterRef every = CallaterInvokeEveryNFrames(RepeatCallback, NULL, 2);
+    CallaterRef far = CallaterInvokeAfterFrames(MultiCallback, NULL, CALLATER_FRAME_BUCKETS + 5);
+    CallaterRef paused = CallaterInvokeAfterFrames(GroupCallback, NULL, 2);
+    CallaterPause(paused);
+    ASSERT(CallaterGetFrame() == 0 && CallaterGetRepeatRate(every) == 2.0f);
+    
+    CallaterUpdate();
+    CallaterUpdate();
+    ASSERT(basic_callback_count == 0 && repeat_callback_count == 1);
+    CallaterUpdate();
+    ASSERT(basic_callback_count == 1 && repeat_callback_count == 1 && CallaterGetFrame() == 3);
+    ASSERT(table.funcs[once.ref] == CallaterNoop);
+    
+    // keeps its 2 frames
+    CallaterResume(paused);
+    CallaterUpdate();
+    ASSERT(group_callback_count == 0 && repeat_callback_count == 2);
+    CallaterUpdate();
+    ASSERT(group_callback_count == 1);
+    
+    // a wait longer than the wheel goes around it
+    CallaterCancel(every);
+    for(uint64_t f = CallaterGetFrame() ; f < CALLATER_FRAME_BUCKETS + 4 ; f++)
+    {
+        CallaterUpdate();
+    }
+    ASSERT(multi_callback_count == 0);
+    CallaterUpdate();
+    ASSERT(multi_callback_count == 1 && table.funcs[far.ref] == CallaterNoop);
+    ASSERT(repeat_callback_count == 2);
+}
+
+void PauseSelfCallback(void* arg, CallaterRef ref) {
+    repeat_callback_count++;
+    CallaterPause(ref);
+}
+
+void TestPauseFrameFromCallback() {
+    TEST("Frame invocation paused from its callback");
+    setup();
+    
+    CallaterRef every = CallaterInvokeEveryNFrames(PauseSelfCallback, NULL, 3);
+    for(int i = 0 ; i < 8 ; i++)
+    {
+        CallaterUpdate();
+    }
+    ASSERT(repeat_callback_count == 1);
+    
+    // it keeps its 3 frames
+    CallaterResume(every);
+    CallaterUpdate();
+    CallaterUpdate();
+    ASSERT(repeat_callback_count == 1);
+    CallaterUpdate();
+    ASSERT(repeat_callback_count == 2);
+    
+    // one that doesn't repeat is due on the next update
+    CallaterRef once = CallaterInvokeAfterFrames(PauseSelfCallback, NULL, 1);
+    CallaterUpdate();
+    CallaterUpdate();
+    ASSERT(repeat_callback_count == 3);
+    CallaterResume(once);
+    CallaterUpdate();
+    ASSERT(repeat_callback_count == 4);
+}
+
+static float step_times[8];
+static int step_count = 0;
+
+// logs the time of the substep it's called in
+void StepCallback(void* arg, CallaterRef ref) {
+    if(step_count < 8)
+        step_times[step_count++] = table.lastUpdated;
+    multi_callback_count += *(int*)arg;
+}
+
+void ChainStepCallback(void* arg, CallaterRef ref) {
+    StepCallback(arg, ref);
+    CallaterInvoke(StepCallback, arg, 0.1f);
+}
+
+void TestUpdateFixed() {
+    TEST("Fixed timestep substeps");
+    setup();
+    step_count = 0;
+    
+    static int first = 1, second = 10, third = 100;
+    CallaterInvoke(StepCallback, &first, 0.1f);
+    CallaterInvoke(StepCallback, &third, 0.3f);
+    CallaterInvoke(StepCallback, &second, 0.26f);
+    
+    // three steps of 1/8th, each invocation runs in the substep it became due in, earliest first
+    mock_current_time = 0.4f;
+    ASSERT(CallaterUpdateFixed(0.125f, 8) == 3);
+    ASSERT(step_count == 3 && multi_callback_count == 111);
+    ASSERT(step_times[0] == 0.125f && step_times[1] == 0.375f && step_times[2] == 0.375f);
+    ASSERT(CallaterGetFrame() == 1);
+    
+    // the leftover 0.025 isn't a whole step
+    ASSERT(CallaterUpdateFixed(0.125f, 8) == 0);
+    
+    // 13 steps are due, the 11 past the limit are carried over to the next calls
+    CallaterInvoke(StepCallback, &first, 0.5f);
+    mock_current_time = 2.0f;
+    ASSERT(CallaterUpdateFixed(0.125f, 2) == 2);
+    ASSERT(step_count == 3 && table.lastUpdated == 0.625f);
+    ASSERT(CallaterUpdateFixed(0.125f, 16) == 11 && table.lastUpdated == 2.0f);
+    ASSERT(step_count == 4 && step_times[3] == 1.0f);
+    
+    // what a callback adds counts from the time of its substep, not from the clock
+    CallaterInvoke(ChainStepCallback, &first, 0.1f);
+    mock_current_time = 2.6f;
+    ASSERT(CallaterUpdateFixed(0.125f, 8) == 4);
+    ASSERT(step_count == 6 && step_times[4] == 2.125f && step_times[5] == 2.25f);
+    
+    // so does what a deferred call adds, it runs before the first substep
+    CallaterDefer(ChainStepCallback, &first);
+    mock_current_time = 3.0f;
+    ASSERT(CallaterUpdateFixed(0.125f, 8) == 4);
+    ASSERT(step_count == 8 && step_times[6] == 2.5f && step_times[7] == 2.625f);
+}
+
 // =====================
 // Main Function
 // =====================
@@ -571,6 +1844,7 @@ int main() {
     TestGroupCancellation();
     TestFunctionCancellation();
     TestImmediateInvocation();
+    TestNegativeDelay();
     TestReferenceManagement();
     TestStressTest();
     
@@ -598,6 +1872,39 @@ int main() {
     TestStopRepeat();
     TestCancelPausedInvocation();
     
+    TestFarHorizon();
+    TestFarRepeatAndPause();
+    TestRepeatCohorts();
+    TestHeapEngine();
+    TestAdaptiveEngine();
+    TestInvokeBatch();
+    TestManyRefs();
+    TestGroupMutators();
+    TestInvokeCopy();
+    TestCustomAllocator();
+    TestAllocationFailure();
+    TestStoreSizes();
+    TestReserveAndFixed();
+    TestVirtualTable();
+    TestCompactMode();
+    TestPauseInTimeLane();
+    TestClocks();
+    TestFrameTime();
+#ifdef CALLATER_HAS_TSC
+    TestTsc();
+#endif
+    TestPrecise();
+    TestWaitPending();
+    TestRepeatPolicies();
+    TestUpdateBudget();
+    TestPriorityLanes();
+    TestStaggeredRepeats();
+    TestSlack();
+    TestDefer();
+    TestFrameInvocations();
+    TestPauseFrameFromCallback();
+    TestUpdateFixed();
+    
     printf("\nTest results: %d/%d passed\n", success_counter, assert_counter);
     return success_counter == assert_counter ? 0 : 1;
 }